@@ -0,0 +1,440 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "josh.h"
+
+static const char *usage =
+	"usage: bench [-t SECONDS] [FILTER]\n"
+	"\n"
+	"Time josh_extract() and josh_parse() on generated documents, printing a\n"
+	"tab separated line per benchmark. Only corpora whose name contains FILTER\n"
+	"are run, if given.\n"
+	"\n"
+	"  -t SECONDS  least time to spend on each benchmark (0.2 by default)\n";
+
+// A document being generated. Whitespace is only written if `pretty` is set,
+// so the same corpus can be generated both minified and pretty printed.
+struct writer_t {
+	char *data;
+	size_t len;
+	size_t capacity;
+	bool pretty;
+	unsigned indent;
+};
+
+// A kind of document. `generate` writes one of roughly `size` bytes, and
+// returns how many elements (or members) it has. `key` writes the key to the
+// value in element `i` to `key`.
+struct corpus_t {
+	const char *name;
+	unsigned (*generate)(struct writer_t *w, size_t size);
+	void (*key)(char *key, size_t len, unsigned i);
+};
+
+static uint64_t random_state;
+
+static unsigned random_below(unsigned n) {
+	// Return a pseudo random number below `n`, which is the same on every run.
+
+	random_state ^= random_state << 13;
+	random_state ^= random_state >> 7;
+	random_state ^= random_state << 17;
+
+	return (unsigned)(random_state % n);
+}
+
+static void reserve(struct writer_t *w, size_t len) {
+	if (w->len + len + 1 <= w->capacity) return;
+
+	while (w->len + len + 1 > w->capacity) w->capacity = w->capacity ? w->capacity * 2 : 4096;
+
+	w->data = realloc(w->data, w->capacity);
+
+	if (!w->data) {
+		fputs("bench: out of memory\n", stderr);
+		exit(1);
+	}
+}
+
+static void put(struct writer_t *w, const char *format, ...) {
+	va_list args;
+	va_start(args, format);
+	va_list copy;
+	va_copy(copy, args);
+
+	const int len = vsnprintf(NULL, 0, format, args);
+	reserve(w, (size_t)len);
+	vsnprintf(w->data + w->len, (size_t)len + 1, format, copy);
+	w->len += (size_t)len;
+
+	va_end(copy);
+	va_end(args);
+}
+
+static void newline(struct writer_t *w) {
+	if (!w->pretty) return;
+
+	put(w, "\n%*s", (int)(w->indent * 2), "");
+}
+
+static void open_container(struct writer_t *w, char c) {
+	put(w, "%c", c);
+	w->indent++;
+}
+
+static void close_container(struct writer_t *w, char c) {
+	w->indent--;
+	newline(w);
+	put(w, "%c", c);
+}
+
+static void next_element(struct writer_t *w, unsigned i) {
+	if (i) put(w, ",");
+
+	newline(w);
+}
+
+static void put_key(struct writer_t *w, const char *key) {
+	put(w, w->pretty ? "\"%s\": " : "\"%s\":", key);
+}
+
+// Every element of the nested corpus is nested this deep, alternating between
+// objects and arrays, which leaves room for the index of the element in a
+// compiled key. The deep corpus goes past JOSH_CONFIG_MAX_DEPTH (up to
+// JOSH_CONFIG_MAX_NESTING), where only a shorter key can look.
+#define NESTED_DEPTH 14
+#define DEEP_DEPTH 48
+#define DEEP_KEY_DEPTH 4
+
+static unsigned generate_levels(struct writer_t *w, size_t size, unsigned depth) {
+	unsigned i = 0;
+
+	open_container(w, '[');
+
+	for (; w->len < size; i++) {
+		next_element(w, i);
+
+		for (unsigned level = 0; level < depth; level++) {
+			if (level % 2) {
+				open_container(w, '[');
+				newline(w);
+			}
+			else {
+				open_container(w, '{');
+				newline(w);
+				put_key(w, "n");
+			}
+		}
+
+		put(w, "%u", i);
+
+		for (unsigned level = depth; level--;) close_container(w, level % 2 ? ']' : '}');
+	}
+
+	close_container(w, ']');
+
+	return i;
+}
+
+static void key_levels(char *key, size_t len, unsigned i, unsigned depth) {
+	int used = snprintf(key, len, "[%u]", i);
+
+	for (unsigned level = 0; level < depth; level++) {
+		used += snprintf(key + used, len - (size_t)used, level % 2 ? "[0]" : ".n");
+	}
+}
+
+static unsigned generate_nested(struct writer_t *w, size_t size) {
+	return generate_levels(w, size, NESTED_DEPTH);
+}
+
+static void key_nested(char *key, size_t len, unsigned i) {
+	key_levels(key, len, i, NESTED_DEPTH);
+}
+
+static unsigned generate_deep(struct writer_t *w, size_t size) {
+	return generate_levels(w, size, DEEP_DEPTH);
+}
+
+static void key_deep(char *key, size_t len, unsigned i) {
+	key_levels(key, len, i, DEEP_KEY_DEPTH);
+}
+
+static unsigned generate_strings(struct writer_t *w, size_t size) {
+	static const char *const pieces[] = {
+		"lorem", "ipsum", "dolor", "sit", "amet", "\\\"quoted\\\"", "line\\nbreak", "caf\\u00e9", "tab\\t", "\\\\",
+	};
+	unsigned i = 0;
+
+	open_container(w, '[');
+
+	for (; w->len < size; i++) {
+		next_element(w, i);
+		open_container(w, '{');
+		newline(w);
+		put_key(w, "id");
+		put(w, "%u,", i);
+		newline(w);
+		put_key(w, "text");
+		put(w, "\"");
+
+		for (unsigned word = 0, words = 20 + random_below(40); word < words; word++) {
+			put(w, word ? " %s" : "%s", pieces[random_below(sizeof(pieces) / sizeof(pieces[0]))]);
+		}
+
+		put(w, "\",");
+		newline(w);
+		put_key(w, "tag");
+		put(w, "\"tag-%u\"", random_below(1000));
+		close_container(w, '}');
+	}
+
+	close_container(w, ']');
+
+	return i;
+}
+
+static void key_strings(char *key, size_t len, unsigned i) {
+	snprintf(key, len, "[%u].text", i);
+}
+
+static unsigned generate_numbers(struct writer_t *w, size_t size) {
+	unsigned i = 0;
+
+	open_container(w, '[');
+
+	for (; w->len < size; i++) {
+		next_element(w, i);
+		open_container(w, '[');
+
+		for (unsigned n = 0; n < 16; n++) {
+			next_element(w, n);
+
+			switch (n % 4) {
+				case 0: put(w, "%u", random_below(1000000)); break;
+				case 1: put(w, "-%u.%03u", random_below(1000), random_below(1000)); break;
+				case 2: put(w, "%u.%ue-%u", random_below(10), random_below(100000), random_below(300)); break;
+				default: put(w, "%uE+%u", random_below(100), random_below(20)); break;
+			}
+		}
+
+		close_container(w, ']');
+	}
+
+	close_container(w, ']');
+
+	return i;
+}
+
+static void key_numbers(char *key, size_t len, unsigned i) {
+	snprintf(key, len, "[%u][15]", i);
+}
+
+static unsigned generate_wide(struct writer_t *w, size_t size) {
+	unsigned i = 0;
+
+	open_container(w, '{');
+
+	for (; w->len < size; i++) {
+		char key[32];
+		snprintf(key, sizeof(key), "key%07u", i);
+
+		next_element(w, i);
+		put_key(w, key);
+		put(w, "%u", random_below(1000));
+	}
+
+	close_container(w, '}');
+
+	return i;
+}
+
+static void key_wide(char *key, size_t len, unsigned i) {
+	snprintf(key, len, ".key%07u", i);
+}
+
+static unsigned generate_array(struct writer_t *w, size_t size) {
+	unsigned i = 0;
+
+	open_container(w, '[');
+
+	for (; w->len < size; i++) {
+		next_element(w, i);
+		open_container(w, '{');
+		newline(w);
+		put_key(w, "x");
+		put(w, "%u,", i);
+		newline(w);
+		put_key(w, "y");
+		put(w, random_below(2) ? "true," : "false,");
+		newline(w);
+		put_key(w, "z");
+		put(w, "null");
+		close_container(w, '}');
+	}
+
+	close_container(w, ']');
+
+	return i;
+}
+
+static void key_array(char *key, size_t len, unsigned i) {
+	snprintf(key, len, "[%u].z", i);
+}
+
+static const struct corpus_t corpora[] = {
+	{ "nested", generate_nested, key_nested },
+	{ "deep", generate_deep, key_deep },
+	{ "strings", generate_strings, key_strings },
+	{ "numbers", generate_numbers, key_numbers },
+	{ "wide", generate_wide, key_wide },
+	{ "array", generate_array, key_array },
+};
+
+// Roughly how big each generated document is.
+#define CORPUS_SIZE (1 << 20)
+
+static double elapsed(const struct timespec *start) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// Keeps the results of the timed calls alive, so they aren't optimized away.
+static volatile size_t sink;
+
+static bool run_extract(struct josh_ctx_t *ctx, const struct writer_t *w, const char *key) {
+	const char *value = josh_extract(ctx, w->data, key);
+
+	sink += ctx->len;
+
+	return value != NULL;
+}
+
+static bool run_parse(struct josh_ctx_t *ctx, const struct writer_t *w, const char *key) {
+	(void)key;
+
+	const struct josh_node_t *root = josh_parse(ctx, w->data);
+
+	sink += ctx->node_count;
+
+	return root != NULL;
+}
+
+static bool report(
+	const char *corpus,
+	const struct writer_t *w,
+	const char *name,
+	bool (*run)(struct josh_ctx_t *ctx, const struct writer_t *w, const char *key),
+	struct josh_ctx_t *ctx,
+	const char *key,
+	double min_seconds
+) {
+	// Time `run` for at least `min_seconds`, doubling the calls between clock
+	// reads, and print a line of results. Return false if a call failed.
+
+	if (!run(ctx, w, key)) {
+		fprintf(stderr, "bench: %s: %s failed with error %d\n", corpus, name, ctx->error_id);
+
+		return false;
+	}
+
+	// Keys near the start stop scanning early, so throughput is over the bytes
+	// up to where the call stopped rather than the whole document.
+	const size_t scanned = (size_t)(ctx->ptr - w->data);
+
+	size_t calls = 0;
+	double seconds = 0;
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	for (size_t batch = 1; seconds < min_seconds; batch *= 2) {
+		for (size_t i = 0; i < batch; i++) run(ctx, w, key);
+
+		calls += batch;
+		seconds = elapsed(&start);
+	}
+
+	// What the parse holds once the unused part of the tape is given back.
+	const size_t arena_bytes = ctx->arena ? ctx->arena->allocated : 0;
+
+	printf(
+		"%s\t%s\t%s\t%zu\t%zu\t%zu\t%.1f\t%.1f\t%zu\n",
+		corpus, w->pretty ? "pretty" : "minified", name, w->len, scanned, calls,
+		seconds * 1e9 / (double)calls, (double)scanned * (double)calls / 1e6 / seconds, arena_bytes
+	);
+	fflush(stdout);
+
+	return true;
+}
+
+int main(int argc, char **argv) {
+	double min_seconds = 0.2;
+	const char *filter = "";
+	int i = 1;
+
+	for (; i < argc && argv[i][0] == '-'; i++) {
+		if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+			min_seconds = strtod(argv[++i], NULL);
+		}
+		else {
+			fputs(usage, stderr);
+
+			return 2;
+		}
+	}
+
+	if (i < argc) filter = argv[i++];
+
+	if (i < argc) {
+		fputs(usage, stderr);
+
+		return 2;
+	}
+
+	struct josh_arena_t arena;
+	struct josh_ctx_t extract_ctx = { 0 };
+	struct josh_ctx_t parse_ctx = { .arena = &arena };
+	int status = 0;
+
+	puts("corpus\tformat\tbench\tbytes\tscanned_bytes\tcalls\tns_per_call\tmb_per_s\tarena_bytes");
+
+	for (size_t c = 0; c < sizeof(corpora) / sizeof(corpora[0]); c++) {
+		const struct corpus_t *corpus = &corpora[c];
+
+		if (!strstr(corpus->name, filter)) continue;
+
+		for (int pretty = 0; pretty < 2; pretty++) {
+			struct writer_t w = { NULL, 0, 0, pretty != 0, 0 };
+
+			random_state = 0x9e3779b97f4a7c15u;
+
+			const unsigned count = corpus->generate(&w, CORPUS_SIZE);
+			const unsigned positions[] = { 0, count / 2, count - 1 };
+			const char *names[] = { "extract_early", "extract_middle", "extract_late" };
+
+			for (unsigned p = 0; p < 3; p++) {
+				char key[256];
+				corpus->key(key, sizeof(key), positions[p]);
+
+				if (!report(corpus->name, &w, names[p], run_extract, &extract_ctx, key, min_seconds)) status = 1;
+			}
+
+			// A fresh arena for each document, without a limit so that the tape
+			// can grow as big as any document needs.
+			josh_arena_init(&arena, NULL, 0);
+			arena.limit = 0;
+
+			if (!report(corpus->name, &w, "parse", run_parse, &parse_ctx, NULL, min_seconds)) status = 1;
+
+			josh_arena_free(&arena);
+			free(w.data);
+		}
+	}
+
+	return status;
+}
@@ -0,0 +1,211 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <time.h>
+
+#include "josh.h"
+
+static const char *usage =
+	"usage: josh [-r] [-s] [-t] [-n [-p] [-j THREADS]] -k KEY [-k KEY]... [FILE]...\n"
+	"\n"
+	"Extract each KEY from every FILE (or stdin if there are none, or FILE is\n"
+	"-), printing the values of each file tab separated on one line.\n"
+	"\n"
+	"  -k KEY      key to extract, such as .users[0].name (up to 64)\n"
+	"  -r          print strings unquoted and unescaped\n"
+	"  -s          print the throughput to stderr when done\n"
+	"  -t          trust the input, only validating the paths to the keys\n"
+	"              (not used with -n)\n"
+	"  -n          read newline delimited JSON, printing a line per record\n"
+	"              (missing values are left empty)\n"
+	"  -p          predict where keys are in each record from the one before,\n"
+	"              for records which all have their keys in the same order\n"
+	"  -j THREADS  threads to use for -n (one per CPU by default)\n";
+
+static bool raw_strings = false;
+static bool shape_hints = false;
+static size_t shape_hits = 0;
+static size_t shape_misses = 0;
+
+static void print_value(const char *value, size_t len) {
+	if (!raw_strings || value[0] != '\"') {
+		fwrite(value, 1, len, stdout);
+
+		return;
+	}
+
+	// Unescaping never makes a string longer, so the quoted length is enough.
+	char *out = malloc(len);
+
+	if (!out) {
+		fputs("josh: out of memory\n", stderr);
+		exit(1);
+	}
+
+	fwrite(out, 1, josh_unescape(out, value + 1, len - 2), stdout);
+	free(out);
+}
+
+static bool print_ndjson(const struct josh_file_t *file, const struct josh_path_t *paths, unsigned count, unsigned threads) {
+	struct josh_ndjson_t out;
+
+	if (!josh_ndjson_extract(&out, file->data, file->len, paths, count, threads, shape_hints)) {
+		josh_ndjson_free(&out);
+
+		return false;
+	}
+
+	shape_hits += out.shape_hits;
+	shape_misses += out.shape_misses;
+
+	for (size_t r = 0; r < out.record_count; r++) {
+		for (unsigned k = 0; k < count; k++) {
+			const size_t i = k * out.record_count + r;
+
+			if (k) putchar('\t');
+			if (!out.error_ids[i]) print_value(file->data + out.offsets[i], out.lens[i]);
+		}
+
+		putchar('\n');
+	}
+
+	josh_ndjson_free(&out);
+
+	return true;
+}
+
+static double elapsed(const struct timespec *start) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+int main(int argc, char **argv) {
+	struct josh_ctx_t ctx = { 0 };
+	struct josh_path_t paths[JOSH_MAX_PATHS];
+	struct josh_result_t results[JOSH_MAX_PATHS];
+	const char *keys[JOSH_MAX_PATHS];
+	unsigned key_count = 0;
+	bool stats = false;
+	bool ndjson = false;
+	unsigned threads = 0;
+	int i = 1;
+
+	for (; i < argc && argv[i][0] == '-' && argv[i][1]; i++) {
+		if (!strcmp(argv[i], "-r")) {
+			raw_strings = true;
+		}
+		else if (!strcmp(argv[i], "-s")) {
+			stats = true;
+		}
+		else if (!strcmp(argv[i], "-t")) {
+			ctx.validation = JOSH_VALIDATION_PATH;
+		}
+		else if (!strcmp(argv[i], "-n")) {
+			ndjson = true;
+		}
+		else if (!strcmp(argv[i], "-p")) {
+			shape_hints = true;
+		}
+		else if (!strcmp(argv[i], "-j") && i + 1 < argc) {
+			threads = (unsigned)strtoul(argv[++i], NULL, 10);
+		}
+		else if (!strcmp(argv[i], "-k") && i + 1 < argc && key_count < JOSH_MAX_PATHS) {
+			keys[key_count] = argv[++i];
+
+			if (!josh_compile_key(&ctx, &paths[key_count], keys[key_count])) {
+				fprintf(stderr, "josh: invalid key %s (error %d)\n", keys[key_count], ctx.error_id);
+
+				return 2;
+			}
+
+			key_count++;
+		}
+		else if (!strcmp(argv[i], "--")) {
+			i++;
+			break;
+		}
+		else {
+			fputs(usage, stderr);
+
+			return 2;
+		}
+	}
+
+	if (!key_count) {
+		fputs(usage, stderr);
+
+		return 2;
+	}
+
+	const char *stdin_only[] = {"-"};
+	const char *const *files = i < argc ? (const char *const *)(argv + i) : stdin_only;
+	const int file_count = i < argc ? argc - i : 1;
+
+	int status = 0;
+	size_t total = 0;
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	for (int f = 0; f < file_count; f++) {
+		const char *name = files[f];
+		const bool is_stdin = !strcmp(name, "-");
+		struct josh_file_t file;
+
+		josh_reset(&ctx);
+
+		if (is_stdin ? !josh_file_read(&ctx, &file, stdin) : !josh_file_open(&ctx, &file, name)) {
+			fprintf(stderr, "josh: %s: cannot read file\n", is_stdin ? "stdin" : name);
+			status = 1;
+
+			continue;
+		}
+
+		total += file.len;
+
+		if (ndjson) {
+			if (!print_ndjson(&file, paths, key_count, threads)) {
+				fprintf(stderr, "josh: %s: out of memory\n", is_stdin ? "stdin" : name);
+				status = 1;
+			}
+
+			josh_file_close(&file);
+
+			continue;
+		}
+
+		if (!josh_extract_many_compiled_n(&ctx, file.data, file.len, paths, results, key_count)) status = 1;
+
+		for (unsigned k = 0; k < key_count; k++) {
+			if (k) putchar('\t');
+
+			if (!results[k].error_id) {
+				print_value(results[k].ptr, results[k].len);
+			}
+			else {
+				ctx.offset = results[k].offset;
+
+				unsigned line, column;
+				josh_error_position(&ctx, &line, &column);
+
+				fprintf(stderr, "josh: %s: %s: error %d at %u:%u\n", is_stdin ? "stdin" : name, keys[k], results[k].error_id, line, column);
+			}
+		}
+
+		putchar('\n');
+		josh_file_close(&file);
+	}
+
+	if (stats) {
+		const double seconds = elapsed(&start);
+
+		fprintf(stderr, "josh: %zu bytes in %.3fs (%.1f MB/s)\n", total, seconds, seconds > 0 ? (double)total / 1e6 / seconds : 0.0);
+
+		if (ndjson && shape_hints) {
+			fprintf(stderr, "josh: %zu records predicted, %zu rescanned\n", shape_hits, shape_misses);
+		}
+	}
+
+	return status;
+}
@@ -1,6 +1,8 @@
 #include <ctype.h>
 #include <float.h>
+#include <limits.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
@@ -12,21 +14,120 @@
 #define JOSH_CONFIG_MAX_DEPTH 16
 #endif
 
-// Defines how big of a memory pool Josh should allocate (on the stack). This
-// is not the size of the Josh context itself, but the memory portion of the
-// context. This memory section is mostly used for constructing JSON trees, not
-// for doing extractions. Depending on how big your JSON data is, you might
-// need to increase this value. Size is specified in bytes.
+// Defines how many arrays and objects deep a document can be nested. The
+// parsers keep their own stack of open containers (in the context or stream)
+// instead of recursing, so this bounds their size rather than the C stack.
+#ifndef JOSH_CONFIG_MAX_NESTING
+#define JOSH_CONFIG_MAX_NESTING 64
+#endif
+
+// Defines the default upper bound on how much memory an arena will hand out
+// before it needs to be reset. Arenas are only needed for constructing JSON
+// trees, not for doing extractions. Depending on how big your JSON data is,
+// you might need to increase this value (or set the `limit` of the arena to
+// zero to remove the limit). Size is specified in bytes.
 #ifndef JOSH_CONFIG_MAX_MEMORY
 #define JOSH_CONFIG_MAX_MEMORY (unsigned)(1024 * 1024 * 8) // 8MB
 #endif
 
+// Defines the minimum size of each block an arena allocates when it needs to
+// grow. Bigger allocations get a block of their own. Size is specified in bytes.
+#ifndef JOSH_CONFIG_ARENA_BLOCK_SIZE
+#define JOSH_CONFIG_ARENA_BLOCK_SIZE (unsigned)(1024 * 64) // 64KB
+#endif
+
 // Allow for trailing comma support. This is not allowed by the spec, but is
 // a common extension, and can be disabed easily in the parser if desired.
 #ifndef JOSH_CONFIG_ALLOW_TRAILING_COMMA
 #define JOSH_CONFIG_ALLOW_TRAILING_COMMA 0
 #endif
 
+// Use SIMD instructions (SSE2 or AVX2, depending on what the compiler is
+// targeting) for scanning strings, and SWAR for converting runs of digits on
+// little endian targets. Set to 0 to always use the scalar code.
+#ifndef JOSH_CONFIG_USE_SIMD
+#define JOSH_CONFIG_USE_SIMD 1
+#endif
+
+// Only keep track of the current position while scanning, and work out the
+// line and column from the offset when an error occurs (or when
+// josh_error_position() is called). Set to 0 to update the line and column
+// for every char instead, which is slower, but keeps them current mid-scan.
+#ifndef JOSH_CONFIG_LAZY_POSITION
+#define JOSH_CONFIG_LAZY_POSITION 1
+#endif
+
+// Whether POSIX is available (define _POSIX_C_SOURCE before including this
+// file in strict C modes).
+#if defined(__APPLE__) || (defined(_POSIX_C_SOURCE) && _POSIX_C_SOURCE >= 200112L)
+#define JOSH_POSIX 1
+#else
+#define JOSH_POSIX 0
+#endif
+
+// Map files into memory in josh_file_open() instead of reading them, which
+// needs POSIX. Set to 0 to read files with stdio instead.
+#ifndef JOSH_CONFIG_USE_MMAP
+#define JOSH_CONFIG_USE_MMAP JOSH_POSIX
+#endif
+
+// Spread the records in josh_ndjson_extract() across threads, which needs
+// POSIX threads (link with -pthread). Set to 0 to always use the calling
+// thread.
+#ifndef JOSH_CONFIG_USE_THREADS
+#define JOSH_CONFIG_USE_THREADS JOSH_POSIX
+#endif
+
+// How many keys josh_extract_many() compiles on the stack (each compiled key
+// takes a few hundred bytes). More keys are compiled into memory from the
+// arena of the context if it has one, or from malloc() otherwise.
+#ifndef JOSH_CONFIG_MANY_STACK_KEYS
+#define JOSH_CONFIG_MANY_STACK_KEYS 8
+#endif
+
+// How many NDJSON records a thread takes at a time.
+#ifndef JOSH_CONFIG_NDJSON_BATCH_SIZE
+#define JOSH_CONFIG_NDJSON_BATCH_SIZE 256
+#endif
+
+#include <stdio.h>
+
+#if JOSH_CONFIG_USE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#if JOSH_CONFIG_USE_MMAP || JOSH_CONFIG_USE_THREADS
+#include <unistd.h>
+#endif
+
+#if JOSH_CONFIG_USE_THREADS
+#include <pthread.h>
+#endif
+
+#if JOSH_CONFIG_USE_SIMD && defined(__AVX2__)
+#include <immintrin.h>
+#elif JOSH_CONFIG_USE_SIMD && defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// For NUL terminated JSON, the SIMD scanners read whole aligned blocks, and
+// the digit parser reads 8 bytes at a time, which can go past the end of the
+// JSON data (but never into the next page), which ASan would flag. Bounded
+// input is never read outside of its bounds.
+#if JOSH_CONFIG_USE_SIMD && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define JOSH_USE_SWAR 1
+#else
+#define JOSH_USE_SWAR 0
+#endif
+
+#if defined(__GNUC__)
+#define JOSH_NO_SANITIZE_ADDRESS __attribute__((no_sanitize_address))
+#else
+#define JOSH_NO_SANITIZE_ADDRESS
+#endif
+
 enum josh_error {
 	JOSH_ERROR_NONE,
 	JOSH_ERROR_EXPECTED_ARRAY,
@@ -54,6 +155,12 @@ enum josh_error {
 	JOSH_ERROR_OUT_OF_MEMORY,
 	JOSH_ERROR_UNEXPECTED_CHAR,
 	JOSH_ERROR_NO_TRAILING_COMMA,
+	JOSH_ERROR_KEY_MAX_COUNT_REACHED,
+	JOSH_ERROR_MAX_NESTING_REACHED,
+	JOSH_ERROR_FILE_NOT_READABLE,
+	JOSH_ERROR_DOCUMENT_TOO_LARGE,
+	JOSH_ERROR_KEY_NOT_STREAMABLE,
+	JOSH_ERROR_EXPECTED_CONTAINER,
 };
 
 enum josh_key_type_t {
@@ -61,33 +168,387 @@ enum josh_key_type_t {
 	JOSH_KEY_TYPE_OBJECT,
 };
 
+// A single step of a compiled key. Object keys have the length (`num`) and
+// hash of their decoded name, which is `str` unless `escaped` is set, in which
+// case `str` still has the JSON escapes of a quoted key in it. A `wildcard`
+// key (`[*]` or `.*`) matches every element of an array or member of an object,
+// or for array slices (`[start:end:step]`), the elements in the slice of the
+// path, starting at `num`.
 struct josh_key_t {
 	enum josh_key_type_t type;
 	unsigned num;
+	uint32_t hash;
+	bool escaped;
+	bool wildcard;
 	const char *str;
 };
 
+// A position in the decoded name of an escaped object key, so that it can be
+// matched a byte at a time without decoding it from the start for each byte.
+// `raw` is where the next char to decode starts, and `at` is the next byte of
+// the `len` bytes in `decoded` (see josh_key_cursor_next()).
+struct josh_key_cursor_t {
+	const char *raw;
+	char decoded[4];
+	unsigned len;
+	unsigned at;
+};
+
+// The end (exclusive) and step of an array wildcard key, which starts at the
+// `num` of the key. The end is UINT_MAX if it runs to the end of the array.
+// The start and end count back from the end of the array if their `from_end`
+// flag is set, which needs the length of the array to be known.
+struct josh_slice_t {
+	unsigned end;
+	unsigned step;
+	bool start_from_end;
+	bool end_from_end;
+};
+
+// A compiled key, as created by josh_compile_key(). A compiled key is never
+// modified once created, meaning it can be reused for any number of
+// extractions, and shared between threads. The object key names (`str`) point
+// into the original key string, which must outlive the compiled key.
+struct josh_path_t {
+	struct josh_key_t keys[JOSH_CONFIG_MAX_DEPTH];
+	unsigned key_count;
+
+	// The array wildcard keys, by level.
+	struct josh_slice_t slices[JOSH_CONFIG_MAX_DEPTH];
+};
+
+// The outcome of extracting a single key. If `error_id` is set then `ptr` will
+// be NULL, and `offset` is where in the JSON data the error occurred.
+struct josh_result_t {
+	const char *ptr;
+	size_t len;
+	enum josh_error error_id;
+	size_t offset;
+};
+
+// A file opened with josh_file_open(). Extracted values and string nodes point
+// into `data`, so it has to stay open for as long as they are used. `data` is
+// not NUL terminated, so use the length-bounded functions with it.
+struct josh_file_t {
+	const char *data;
+	size_t len;
+	bool mapped;
+};
+
+// The results of josh_ndjson_extract(), stored by column. Record `r` is at
+// `record_offsets[r]` in the data (excluding its newline), and the value of
+// path `p` in record `r` is at index `p * record_count + r` of `offsets`,
+// `lens` and `error_ids`. Offsets are relative to the start of the data, and
+// are where the error occurred for missing values.
+struct josh_ndjson_t {
+	size_t record_count;
+	size_t *record_offsets;
+	size_t *record_lens;
+	size_t *offsets;
+	size_t *lens;
+	enum josh_error *error_ids;
+
+	// Set if the whole extraction failed (such as from running out of memory).
+	enum josh_error error_id;
+
+	// With `shape_hints`, the number of records the predictions of where keys
+	// are held for and didn't.
+	size_t shape_hits;
+	size_t shape_misses;
+};
+
+// A position in an array or object, as created by josh_cursor_enter(). It only
+// points into the JSON, so it can be copied to remember a place. `value` is the
+// current element (NULL before the first one), and `key` is its key without
+// the quotes (and with escapes left as is) if the container is an object.
+// Errors are reported relative to `start`, the start of the container.
+struct josh_cursor_t {
+	const char *start;
+	const char *ptr;
+	const char *end;
+	bool is_object;
+	unsigned index;
+	const char *key;
+	size_t key_len;
+	const char *value;
+	size_t value_len;
+};
+
+// A value in a document index (see josh_index_build()), in document order.
+// `start` and `len` are its span in the document, and `key` and `key_len` the
+// key it has in its object (without the quotes, escapes left as is). `size` is
+// the number of entries in it (including itself), and for arrays and objects,
+// its `count` children are listed in the members of the index from `children`.
+struct josh_index_entry_t {
+	uint32_t start;
+	uint32_t len;
+	uint32_t key;
+	uint32_t key_len;
+	uint32_t size;
+	uint32_t count;
+	uint32_t children;
+};
+
+// A child of an array or object in a document index. The children of arrays
+// are in order, and those of objects are sorted by the hash of their (decoded)
+// keys, then by order, so they can be binary searched.
+struct josh_index_member_t {
+	uint32_t hash;
+	uint32_t entry;
+};
+
+// An index of a document, made by josh_index_build(), which lets any key be
+// extracted without scanning the document again. Both arrays are provided by
+// the caller, with room for `capacity` items each. The index only holds
+// offsets, so it can be saved along with the document and used again later.
+struct josh_index_t {
+	struct josh_index_entry_t *entries;
+	struct josh_index_member_t *members;
+	uint32_t count;
+	uint32_t capacity;
+};
+
+// Max number of keys that can be extracted in one go. Each key is tracked as
+// a bit in a 64 bit mask, so this cannot be increased.
+#define JOSH_MAX_PATHS 64
+
+// Where the keys being extracted were found in the last document, which is
+// checked first in the next one (see `shape` in josh_ctx_t). `ordinals` holds
+// which member of each object level every key matched, and `known` the keys
+// that were found. Documents the prediction held for are counted in `hits`,
+// and the rest in `misses`. It must be zeroed before its first use.
+struct josh_shape_t {
+	const struct josh_path_t *paths;
+	unsigned path_count;
+	uint64_t known;
+	unsigned ordinals[JOSH_MAX_PATHS][JOSH_CONFIG_MAX_DEPTH];
+
+	size_t hits;
+	size_t misses;
+};
+
+#define JOSH_ALIGNOF(type) offsetof(struct { char c; type t; }, t)
+
+struct josh_arena_block_t {
+	struct josh_arena_block_t *next;
+	size_t size;
+	bool owned;
+};
+
+// A growable arena made up of a linked list of blocks. The first block can
+// optionally be a buffer supplied by the caller, and additional blocks are
+// requested from `alloc` as needed (if `alloc` is NULL, the arena is fixed in
+// size). Resetting an arena keeps all of its blocks around for reuse, and
+// doesn't clear any memory. Use josh_arena_init() to create an arena.
+struct josh_arena_t {
+	void *(*alloc)(void *user, size_t bytes);
+	void (*free)(void *user, void *ptr);
+	void *user;
+	size_t block_size;
+	size_t limit;
+
+	struct josh_arena_block_t *head;
+	struct josh_arena_block_t *current;
+	size_t used;
+
+	// Bytes handed out since the last reset, and the most bytes ever handed
+	// out between resets.
+	size_t allocated;
+	size_t high_water;
+};
+
+// An array or object which is open in the context. `active` are the keys
+// which matched all levels leading up to it, and `found` are the keys which
+// will be found once its current child (at `index`) ends.
+struct josh_frame_t {
+	uint64_t active;
+	uint64_t found;
+	unsigned index;
+
+	// For objects while predicting the shape, the next child any key is
+	// expected at. For arrays with slices counting from their end, how many
+	// children they have.
+	unsigned hint;
+};
+
+enum josh_validation_t {
+	// Check that everything up to where extraction stops is valid JSON.
+	JOSH_VALIDATION_FULL,
+
+	// Only validate the containers leading to extracted values, and the values
+	// themselves. Everything else is skipped by matching up brackets and
+	// quotes, so only use this for trusted input.
+	JOSH_VALIDATION_PATH,
+};
+
 struct josh_ctx_t {
 	const char *start;
 	const char *ptr;
+	// End of the JSON for length-bounded input, or NULL if it is NUL terminated.
+	const char *end;
 	size_t len;
 	enum josh_error error_id;
 	unsigned line;
-	unsigned offset;
+	size_t offset;
 	unsigned column;
 
 	struct josh_key_t keys[JOSH_CONFIG_MAX_DEPTH];
 	unsigned key_count;
 
-	unsigned current_index;
 	unsigned current_level;
-	unsigned match_count;
-	bool found_key;
 	bool create_node;
-	const char *value_pos;
 
-	size_t allocated;
-	uint8_t memory[JOSH_CONFIG_MAX_MEMORY];
+	// Arrays and objects which are open, `depth` of them. Keys can only match
+	// the first JOSH_CONFIG_MAX_DEPTH levels, so only those need a frame, and
+	// every other level just has a bit saying whether it is an object. While
+	// building a tape, `open_node` is the innermost open container node.
+	struct josh_frame_t frames[JOSH_CONFIG_MAX_DEPTH];
+	uint64_t objects[(JOSH_CONFIG_MAX_NESTING + 63) / 64];
+	unsigned depth;
+	unsigned open_node;
+
+	// How many of the values being extracted the current position is inside.
+	unsigned open_targets;
+
+	// Set by josh_iter_string() if the last string it scanned had escapes.
+	bool has_escapes;
+
+	// Keys which are being extracted. `active` are the keys which matched all
+	// levels leading up to the current value, and `pending` are the keys which
+	// haven't been found yet (or errored). `done` is set once all of them have.
+	const struct josh_path_t *paths;
+	struct josh_result_t *results;
+	unsigned path_count;
+	uint64_t active;
+	uint64_t pending;
+	bool done;
+
+	// Memory used by josh_parse(). This is not touched by josh_reset(), and
+	// can be left NULL if only doing extractions.
+	struct josh_arena_t *arena;
+
+	// How much of the document extractions validate. This is not touched by
+	// josh_reset(), and defaults to JOSH_VALIDATION_FULL.
+	enum josh_validation_t validation;
+
+	// Called with the index of each key as soon as its result is known, if
+	// set. Keys with a wildcard in them are then reported for every value they
+	// match, and the last one is left in their result. Otherwise they only
+	// match the first value. Neither is touched by josh_reset().
+	void (*callback)(void *user, unsigned index, const struct josh_result_t *result);
+	void *user;
+
+	// The keys being extracted which have a wildcard in them, and those with
+	// a slice counting from the end of an array.
+	uint64_t wildcards;
+	uint64_t from_end;
+
+	// If set, extractions predict which object members the keys are in from
+	// the last document, and only compare those, which saves most of the key
+	// comparisons when every document has its keys in the same order. If a
+	// prediction doesn't hold, `mispredicted` is set and the document is
+	// scanned again without them. Objects are assumed not to have duplicate
+	// keys, and the shape is not used with a callback. This is not touched by
+	// josh_reset().
+	struct josh_shape_t *shape;
+	bool predicting;
+	bool mispredicted;
+
+	// The tape built by josh_parse(), which is a contiguous array of
+	// `node_count` nodes (with room for `node_capacity`) starting at the root.
+	struct josh_node_t *root;
+	unsigned node_count;
+	unsigned node_capacity;
+};
+
+enum josh_stream_state_t {
+	JOSH_STREAM_STATE_VALUE,
+	JOSH_STREAM_STATE_FIRST_VALUE,
+	JOSH_STREAM_STATE_NEXT_VALUE,
+	JOSH_STREAM_STATE_FIRST_KEY,
+	JOSH_STREAM_STATE_NEXT_KEY,
+	JOSH_STREAM_STATE_COLON,
+	JOSH_STREAM_STATE_AFTER_VALUE,
+	JOSH_STREAM_STATE_STRING,
+	JOSH_STREAM_STATE_STRING_ESCAPE,
+	JOSH_STREAM_STATE_STRING_UNICODE,
+	JOSH_STREAM_STATE_NUMBER,
+	JOSH_STREAM_STATE_LITERAL,
+	JOSH_STREAM_STATE_END,
+	JOSH_STREAM_STATE_ERROR,
+};
+
+// An array or object which is open in the streaming parser. The document
+// itself is the frame at the bottom of the stack.
+struct josh_stream_frame_t {
+	// Keys which matched all levels leading up to this container, and keys
+	// which will be found once its current child value ends.
+	uint64_t active;
+	uint64_t found;
+	size_t value_start;
+	unsigned index;
+	bool is_object;
+};
+
+// State of a push parser, which extracts keys from a document that is fed to
+// it in chunks (see josh_stream_init()). All state lives here rather than on
+// the call stack, so parsing can stop at the end of any chunk, including in
+// the middle of a token.
+struct josh_stream_t {
+	const struct josh_path_t *paths;
+	struct josh_result_t *results;
+	unsigned path_count;
+
+	// Called with the index of each key as soon as its result is known, if
+	// set. The `ptr` of the result is only valid until the callback returns.
+	void (*callback)(void *user, unsigned index, const struct josh_result_t *result);
+	void *user;
+
+	// Used to copy values which span more than one chunk, if set. Otherwise
+	// such values are reported with a NULL `ptr` (but a valid offset and len).
+	struct josh_arena_t *arena;
+
+	enum josh_error error_id;
+	size_t offset;
+	uint64_t pending;
+	bool done;
+
+	// The keys which have a wildcard in them. Like with a context, these are
+	// reported for every value they match if there is a callback.
+	uint64_t wildcards;
+
+	enum josh_stream_state_t state;
+	unsigned step;
+	const char *literal;
+	enum josh_error literal_error;
+	bool in_key;
+	uint64_t key_matches;
+	unsigned key_len;
+	struct josh_key_cursor_t key_cursors[JOSH_MAX_PATHS];
+
+	// The \u escape being read, and a high surrogate waiting for its pair.
+	// Keys are matched against the decoded chars, like josh_unescape().
+	unsigned code;
+	unsigned high_surrogate;
+
+	// The chunk being parsed, and where it starts in the document.
+	const char *chunk;
+	size_t chunk_offset;
+
+	// Where the root value ends. Keys for the whole document are only found
+	// once josh_stream_finish() has checked that nothing else follows.
+	size_t document_end;
+
+	// Copy of the document from `capture_start`, kept while a value which is
+	// being extracted is still open at the end of a chunk. Once no value is
+	// open, it is left to the results which point into it.
+	char *capture;
+	size_t capture_start;
+	size_t capture_len;
+	size_t capture_capacity;
+
+	unsigned depth;
+	struct josh_stream_frame_t stack[JOSH_CONFIG_MAX_NESTING + 1];
 };
 
 enum josh_node_type_t {
@@ -98,50 +559,137 @@ enum josh_node_type_t {
 	JOSH_NODE_TYPE_FLOAT,
 	JOSH_NODE_TYPE_ARRAY,
 	JOSH_NODE_TYPE_OBJECT,
+	JOSH_NODE_TYPE_STRING,
+	JOSH_NODE_TYPE_KEY,
 };
 
+// Nodes are stored in document order on a flat tape. Arrays are followed by
+// their elements, and objects by a key node and a value for each member.
+// Containers record how many nodes they span (including themselves) so that
+// their siblings can be found without walking their children, and strings and
+// keys are stored as an offset and length into the original JSON, without the
+// quotes and with any escapes left as is.
+//
+// Each node is a 4 bit type tag plus an 8 byte payload, for 16 bytes in total
+// on 64 bit targets. Literals are encoded entirely by their tag.
 struct josh_node_t {
-	enum josh_node_type_t type;
+	unsigned type : 4; // enum josh_node_type_t
+	unsigned has_escapes : 1; // Set for strings and keys which contain escapes
 	union {
-		long double _float;
+		double _float;
 		long long int _int;
+		struct {
+			uint32_t size;
+			uint32_t count;
+		} _container;
+		struct {
+			uint32_t offset;
+			uint32_t len;
+		} _string;
 	} value;
 };
 
 static inline bool josh_is_value_terminator(char c) {
-	return c == ',' || c == ']' || c == '}' || c == '\0';
+	return (
+		c == ',' ||
+		c == ']' ||
+		c == '}' ||
+		c == '\0' ||
+		c == ' ' ||
+		c == '\n' ||
+		c == '\r' ||
+		c == '\t' ||
+		c == '\f'
+	);
 }
 
 void josh_reset(struct josh_ctx_t *ctx);
 bool josh_parse_key(struct josh_ctx_t *ctx, const char *key);
+bool josh_compile_key(struct josh_ctx_t *ctx, struct josh_path_t *path, const char *key);
 bool josh_iter_value(struct josh_ctx_t *ctx);
-bool josh_iter_array(struct josh_ctx_t *ctx);
-bool josh_iter_object(struct josh_ctx_t *ctx);
 bool josh_iter_string(struct josh_ctx_t *ctx);
+static bool josh_skip_value(struct josh_ctx_t *ctx);
 bool josh_iter_number(struct josh_ctx_t *ctx);
 bool josh_iter_literal(struct josh_ctx_t *ctx);
 static inline char josh_iter_whitespace(struct josh_ctx_t *ctx);
+static inline bool josh_is_whitespace(char c);
 static inline char josh_step_char(struct josh_ctx_t *ctx);
 static inline char josh_step_n_chars(struct josh_ctx_t *ctx, unsigned n);
+static inline char josh_peek_char(const struct josh_ctx_t *ctx, size_t n);
+static inline bool josh_has_chars(const struct josh_ctx_t *ctx, size_t n);
+static inline bool josh_match_literal(const struct josh_ctx_t *ctx, const char *literal, size_t len);
 void *josh_malloc(struct josh_ctx_t *ctx, size_t bytes);
-
+void josh_error_position(const struct josh_ctx_t *ctx, unsigned *line, unsigned *column);
+size_t josh_unescape(char *out, const char *str, size_t len);
+const char *josh_string_value(struct josh_ctx_t *ctx, const char *json, const struct josh_node_t *node, size_t *len);
+bool josh_stream_init(struct josh_stream_t *stream, const struct josh_path_t *paths, struct josh_result_t *results, unsigned count);
+bool josh_stream_feed(struct josh_stream_t *stream, const char *chunk, size_t len);
+bool josh_stream_finish(struct josh_stream_t *stream);
+void josh_arena_reset(struct josh_arena_t *arena);
+void *josh_arena_alloc(struct josh_arena_t *arena, size_t bytes, size_t align);
+void *josh_arena_realloc(struct josh_arena_t *arena, void *ptr, size_t old_bytes, size_t new_bytes, size_t align);
+static size_t josh_arena_room(const struct josh_arena_t *arena, const void *ptr, size_t bytes, size_t align);
+static inline struct josh_node_t *josh_alloc_node(struct josh_ctx_t *ctx, enum josh_node_type_t type);
+static inline struct josh_node_t *josh_alloc_string_node(struct josh_ctx_t *ctx, enum josh_node_type_t type, const char *start);
+static inline void josh_close_container_node(struct josh_ctx_t *ctx, unsigned index, unsigned count);
+
+#if JOSH_CONFIG_LAZY_POSITION
+#define JOSH_ERROR(ctx, id) \
+	(ctx)->error_id = (id); \
+	(ctx)->offset = (size_t)((ctx)->ptr - (ctx)->start); \
+	(ctx)->len = 0; \
+	josh_error_position((ctx), &(ctx)->line, &(ctx)->column);
+#else
 #define JOSH_ERROR(ctx, id) \
 	(ctx)->error_id = (id); \
-	(ctx)->offset = (unsigned)((ctx)->ptr - (ctx)->start); \
+	(ctx)->offset = (size_t)((ctx)->ptr - (ctx)->start); \
 	(ctx)->len = 0;
+#endif
 
 void josh_reset(struct josh_ctx_t *ctx) {
-	memset(ctx, 0, sizeof(*ctx));
+	// Reset the scanning state of the context. Only the fields which are read
+	// before being written are cleared, making this cheap enough to call for
+	// every extraction.
+
+	ctx->start = ctx->ptr = ctx->end = NULL;
+	ctx->len = 0;
+	ctx->error_id = JOSH_ERROR_NONE;
 	ctx->line = ctx->column = 1;
+	ctx->offset = 0;
+	ctx->key_count = 0;
+	ctx->current_level = 0;
+	ctx->depth = 0;
+	ctx->open_targets = 0;
+	ctx->create_node = false;
+	ctx->has_escapes = false;
+	ctx->paths = NULL;
+	ctx->results = NULL;
+	ctx->path_count = 0;
+	ctx->active = 0;
+	ctx->pending = 0;
+	ctx->done = false;
+	ctx->predicting = ctx->mispredicted = false;
+	ctx->root = NULL;
+	ctx->node_count = 0;
+	ctx->node_capacity = 0;
 }
 
-struct josh_node_t *josh_parse(struct josh_ctx_t *ctx, const char *json) {
-	josh_reset(ctx);
+static struct josh_node_t *josh_parse_document(struct josh_ctx_t *ctx, const char *json) {
+	// Build the tape for `json`. The context is expected to have already been
+	// reset.
 
 	ctx->ptr = ctx->start = json;
 	ctx->create_node = true;
 
-	if (!*ctx->ptr) {
+	if (!ctx->arena) {
+		JOSH_ERROR(ctx, JOSH_ERROR_OUT_OF_MEMORY);
+
+		return NULL;
+	}
+
+	josh_arena_reset(ctx->arena);
+
+	if (!josh_peek_char(ctx, 0)) {
 		JOSH_ERROR(ctx, JOSH_ERROR_EMPTY_VALUE);
 
 		return NULL;
@@ -149,9 +697,23 @@ struct josh_node_t *josh_parse(struct josh_ctx_t *ctx, const char *json) {
 
 	josh_iter_whitespace(ctx);
 
-	struct josh_node_t *root = (void *)ctx->memory;
+	const bool ok = josh_iter_value(ctx);
+
+	// Give the part of the tape the document didn't need back to the arena.
+	if (ctx->root) {
+		ctx->root = josh_arena_realloc(
+			ctx->arena,
+			ctx->root,
+			ctx->node_capacity * sizeof(struct josh_node_t),
+			ctx->node_count * sizeof(struct josh_node_t),
+			JOSH_ALIGNOF(struct josh_node_t)
+		);
+		ctx->node_capacity = ctx->node_count;
+	}
+
+	if (ok) {
+		struct josh_node_t *root = ctx->root;
 
-	if (josh_iter_value(ctx)) {
 		if (!josh_iter_whitespace(ctx)) return root;
 
 		JOSH_ERROR(ctx, JOSH_ERROR_UNEXPECTED_CHAR);
@@ -162,6 +724,31 @@ struct josh_node_t *josh_parse(struct josh_ctx_t *ctx, const char *json) {
 	return NULL;
 }
 
+struct josh_node_t *josh_parse(struct josh_ctx_t *ctx, const char *json) {
+	josh_reset(ctx);
+
+	return josh_parse_document(ctx, json);
+}
+
+struct josh_node_t *josh_parse_n(struct josh_ctx_t *ctx, const char *json, size_t len) {
+	// Same as josh_parse(), except `json` is `len` chars long and does not need
+	// to be NUL terminated.
+
+	josh_reset(ctx);
+
+	// String nodes hold 32 bit offsets, so they can't point any further.
+	if (len > UINT32_MAX) {
+		ctx->ptr = ctx->start = json;
+		JOSH_ERROR(ctx, JOSH_ERROR_DOCUMENT_TOO_LARGE);
+
+		return NULL;
+	}
+
+	ctx->end = json + len;
+
+	return josh_parse_document(ctx, json);
+}
+
 #define josh_is_null(node) ((node)->type == JOSH_NODE_TYPE_NULL)
 #define josh_is_true(node) ((node)->type == JOSH_NODE_TYPE_TRUE)
 #define josh_is_false(node) ((node)->type == JOSH_NODE_TYPE_FALSE)
@@ -172,605 +759,4913 @@ struct josh_node_t *josh_parse(struct josh_ctx_t *ctx, const char *json) {
 #define josh_int_value(node) ((node)->value._int)
 #define josh_float_value(node) ((node)->value._float)
 #define josh_is_array(node) ((node)->type == JOSH_NODE_TYPE_ARRAY)
-#define josh_is_array_empty(node) (true)
+#define josh_is_array_empty(node) ((node)->value._container.count == 0)
+#define josh_array_size(node) ((node)->value._container.count)
 #define josh_is_object(node) ((node)->type == JOSH_NODE_TYPE_OBJECT)
-#define josh_is_object_empty(node) (true)
-
-const char *josh_extract(struct josh_ctx_t *ctx, const char *json, const char *key) {
-	josh_reset(ctx);
-
-	ctx->ptr = ctx->start = json;
+#define josh_is_object_empty(node) ((node)->value._container.count == 0)
+#define josh_object_size(node) ((node)->value._container.count)
+#define josh_is_container(node) ((node)->type == JOSH_NODE_TYPE_ARRAY || (node)->type == JOSH_NODE_TYPE_OBJECT)
+#define josh_is_string(node) ((node)->type == JOSH_NODE_TYPE_STRING)
+#define josh_is_key(node) ((node)->type == JOSH_NODE_TYPE_KEY)
+#define josh_string_ptr(json, node) ((json) + (node)->value._string.offset)
+#define josh_string_len(node) ((node)->value._string.len)
+#define josh_string_has_escapes(node) ((node)->has_escapes)
 
-	if (!josh_parse_key(ctx, key)) return NULL;
+// Navigation over the tape. The first child of a non-empty container is the
+// node right after it, and the value of a key is the node right after the key.
+// Iterating the children of a container stops at josh_next(container).
+#define josh_first_child(node) ((node) + 1)
+#define josh_key_value(node) ((node) + 1)
+#define josh_next(node) ((node) + (josh_is_container(node) ? (node)->value._container.size : 1))
 
-	if (!ctx->key_count) {
-		ctx->found_key = true;
-		ctx->value_pos = json;
-	}
+static inline struct josh_node_t *josh_array_get(struct josh_node_t *node, unsigned index) {
+	// Return element `index` of the array `node`, or NULL if it is out of
+	// bounds. Each element before it is skipped in constant time.
 
-	if (!*ctx->ptr) {
-		JOSH_ERROR(ctx, JOSH_ERROR_EMPTY_VALUE);
+	if (index >= josh_array_size(node)) return NULL;
 
-		return NULL;
-	}
+	struct josh_node_t *child = josh_first_child(node);
 
-	josh_iter_whitespace(ctx);
+	while (index--) child = josh_next(child);
 
-	if (!ctx->key_count) {
-		if (josh_iter_value(ctx)) {
-			if (!josh_iter_whitespace(ctx)) return ctx->value_pos;
+	return child;
+}
 
-			JOSH_ERROR(ctx, JOSH_ERROR_UNEXPECTED_CHAR);
+static inline unsigned josh_ctz64(uint64_t x) {
+#if defined(__GNUC__)
+	return (unsigned)__builtin_ctzll(x);
+#else
+	unsigned n = 0;
 
-			return NULL;
-		}
-	}
-	else if (ctx->keys[0].type == JOSH_KEY_TYPE_OBJECT) {
-		if (josh_iter_object(ctx)) return ctx->value_pos;
-	}
-	else if (ctx->keys[0].type == JOSH_KEY_TYPE_ARRAY) {
-		if (josh_iter_array(ctx)) return ctx->value_pos;
+	while (!(x & 1)) {
+		x >>= 1;
+		n++;
 	}
 
-	return NULL;
+	return n;
+#endif
 }
 
-bool josh_iter_value(struct josh_ctx_t *ctx) {
-	// Parse a JSON value from ctx. Return true if the function succeeds.
-
-	const char c = *ctx->ptr;
+static inline unsigned josh_popcount64(uint64_t x) {
+#if defined(__GNUC__)
+	return (unsigned)__builtin_popcountll(x);
+#else
+	unsigned n = 0;
 
-	if (c == '\"') {
-		if (!josh_iter_string(ctx)) return false;
-	}
-	else if (c == '[') {
-		const unsigned temp = ctx->current_index;
-		ctx->current_index = 0;
-		ctx->current_level++;
+	for (; x; x &= x - 1) n++;
 
-		if (!josh_iter_array(ctx)) return false;
+	return n;
+#endif
+}
 
-		ctx->current_level--;
-		ctx->current_index = temp;
-	}
-	else if (c == '{') {
-		ctx->current_level++;
+static inline unsigned josh_msb64(uint64_t x) {
+	// Return the index of the highest set bit in `x`, which must not be zero.
 
-		if (!josh_iter_object(ctx)) return false;
+#if defined(__GNUC__)
+	return 63 - (unsigned)__builtin_clzll(x);
+#else
+	unsigned n = 0;
 
-		ctx->current_level--;
-	}
-	else if (isdigit(c) || c == '-') {
-		if (!josh_iter_number(ctx)) return false;
-	}
-	else {
-		if (!josh_iter_literal(ctx)) return false;
-	}
+	while (x >>= 1) n++;
 
-	return true;
+	return n;
+#endif
 }
 
-bool josh_iter_array(struct josh_ctx_t *ctx) {
-	// Iterate until the end of an array, exiting early if the index indicated
-	// by `ctx->keys` is found. Return true upon success, or false on error.
+static inline unsigned josh_hex_value(char c) {
+	// Return the value of the hex digit `c`.
 
-	if (
-		!ctx->found_key &&
-		ctx->keys[ctx->current_level].type == JOSH_KEY_TYPE_ARRAY &&
-		*ctx->ptr != '['
-	) {
-		JOSH_ERROR(ctx, JOSH_ERROR_EXPECTED_ARRAY);
+	if (c >= '0' && c <= '9') return (unsigned)(c - '0');
+	if (c >= 'a' && c <= 'f') return (unsigned)(c - 'a' + 10);
 
-		return false;
-	}
+	return (unsigned)(c - 'A' + 10);
+}
 
-	josh_step_char(ctx);
-	josh_iter_whitespace(ctx);
+static inline unsigned josh_parse_hex4(const char *str) {
+	// Return the value of the 4 hex digits at `str`.
 
-	if (ctx->create_node) {
-		struct josh_node_t *node = josh_malloc(ctx, sizeof(struct josh_node_t));
-		node->type = JOSH_NODE_TYPE_ARRAY;
-	}
+	unsigned value = 0;
 
-	for (;;) {
-		if (*ctx->ptr == ']') {
-			if (ctx->found_key || ctx->create_node) {
-				josh_step_char(ctx);
+	for (unsigned i = 0; i < 4; i++) value = (value << 4) | josh_hex_value(str[i]);
 
-				return true;
-			}
+	return value;
+}
 
-			JOSH_ERROR(ctx, JOSH_ERROR_ARRAY_INDEX_NOT_FOUND);
+static const char *josh_key_next(const char *raw, char out[4], unsigned *len) {
+	// Decode the next char of the escaped object key name `raw` into `out` the
+	// same way josh_unescape() does, setting `len` to the number of bytes it
+	// decoded to. Returns where the next char starts.
 
-			return false;
-		}
+	size_t run = 1;
 
-		if (
-			ctx->current_level < ctx->key_count &&
-			ctx->keys[ctx->current_level].type == JOSH_KEY_TYPE_ARRAY &&
-			ctx->keys[ctx->current_level].num == ctx->current_index
-		) {
-			ctx->match_count++;
+	if (raw[0] == '\\') {
+		run = raw[1] == 'u' ? 6 : 2;
 
-			if (ctx->match_count == ctx->key_count) {
-				ctx->found_key = true;
-				ctx->value_pos = ctx->ptr;
-			}
+		if (run == 6 && (josh_parse_hex4(raw + 2) & 0xfc00) == 0xd800 && raw[6] == '\\' && raw[7] == 'u') {
+			if ((josh_parse_hex4(raw + 8) & 0xfc00) == 0xdc00) run = 12;
 		}
+	}
 
-		if (!josh_iter_value(ctx)) return false;
+	*len = (unsigned)josh_unescape(out, raw, run);
 
-		if (ctx->found_key && ctx->current_level < ctx->key_count) break;
+	return raw + run;
+}
 
-		josh_iter_whitespace(ctx);
+static inline bool josh_key_equals(const struct josh_key_t *k, const char *key) {
+	// Compare the name of the object key `k` with `key`, which is the same
+	// length (`k->num`) once decoded.
 
-		if (*ctx->ptr == ',') {
-			ctx->current_index++;
-			josh_step_char(ctx);
-			const char c = josh_iter_whitespace(ctx);
+	if (!k->escaped) return memcmp(k->str, key, k->num) == 0;
 
-#if JOSH_CONFIG_ALLOW_TRAILING_COMMA == 0
-			if (c == ']') {
-				JOSH_ERROR(ctx, JOSH_ERROR_NO_TRAILING_COMMA);
+	const char *raw = k->str;
+	char c[4];
+	unsigned len = 0;
 
-				return false;
-			}
-#endif
-		}
+	for (unsigned i = 0; i < k->num; i += len) {
+		raw = josh_key_next(raw, c, &len);
+
+		if (memcmp(c, key + i, len) != 0) return false;
 	}
 
 	return true;
 }
 
-bool josh_iter_object(struct josh_ctx_t *ctx) {
-	// Iterate until the end of an object, exiting early if the key indicated
-	// by `ctx->keys` is found. Return true upon success, or false on error.
+static inline void josh_key_cursor_init(struct josh_key_cursor_t *cursor, const struct josh_key_t *k) {
+	// Start a cursor at the first byte of the decoded name of the key `k`.
 
-	if (
-		!ctx->found_key &&
-		ctx->keys[ctx->current_level].type == JOSH_KEY_TYPE_OBJECT &&
-		*ctx->ptr != '{'
-	) {
-		JOSH_ERROR(ctx, JOSH_ERROR_EXPECTED_OBJECT);
+	cursor->raw = k->str;
+	cursor->len = cursor->at = 0;
+}
 
-		return false;
+static inline char josh_key_cursor_next(struct josh_key_cursor_t *cursor) {
+	// Return the next byte of the decoded name, decoding the next char of the
+	// escaped name once the bytes of the last one are used up. The caller
+	// makes sure not to read past the end of the name.
+
+	if (cursor->at == cursor->len) {
+		cursor->raw = josh_key_next(cursor->raw, cursor->decoded, &cursor->len);
+		cursor->at = 0;
 	}
 
-	josh_step_char(ctx);
-	josh_iter_whitespace(ctx);
+	return cursor->decoded[cursor->at++];
+}
 
-	if (ctx->create_node) {
-		struct josh_node_t *node = josh_malloc(ctx, sizeof(struct josh_node_t));
-		node->type = JOSH_NODE_TYPE_OBJECT;
-	}
+#define JOSH_HASH_BASIS 2166136261u
 
+static inline uint32_t josh_hash_extend(uint32_t hash, const char *str, size_t len) {
+	// Continue the 32 bit FNV-1a `hash` of a string with `len` more chars.
 
-	for (;;) {
-		if (*ctx->ptr == '}') {
-			if (ctx->found_key || ctx->create_node) {
-				josh_step_char(ctx);
+	for (size_t i = 0; i < len; i++) {
+		hash ^= (uint8_t)str[i];
+		hash *= 16777619u;
+	}
 
-				return true;
-			}
+	return hash;
+}
 
-			JOSH_ERROR(ctx, JOSH_ERROR_OBJECT_KEY_NOT_FOUND);
+static inline uint32_t josh_hash(const char *str, size_t len) {
+	// Hash a string using 32 bit FNV-1a.
 
-			return false;
-		}
+	return josh_hash_extend(JOSH_HASH_BASIS, str, len);
+}
 
-		const char *key = ctx->ptr + 1;
+#define JOSH_POW10_MIN_EXPONENT (-342)
+#define JOSH_POW10_MAX_EXPONENT 308
+
+// Powers of ten from 1e-342 to 1e308, normalized so that the high bit is set
+// and truncated to 128 bits. Stored as { high, low } 64 bit halves.
+static const uint64_t josh_pow10_table[][2] = {
+	{ 0xeef453d6923bd65aULL, 0x113faa2906a13b3fULL }, { 0x9558b4661b6565f8ULL, 0x4ac7ca59a424c507ULL },
+	{ 0xbaaee17fa23ebf76ULL, 0x5d79bcf00d2df649ULL }, { 0xe95a99df8ace6f53ULL, 0xf4d82c2c107973dcULL },
+	{ 0x91d8a02bb6c10594ULL, 0x79071b9b8a4be869ULL }, { 0xb64ec836a47146f9ULL, 0x9748e2826cdee284ULL },
+	{ 0xe3e27a444d8d98b7ULL, 0xfd1b1b2308169b25ULL }, { 0x8e6d8c6ab0787f72ULL, 0xfe30f0f5e50e20f7ULL },
+	{ 0xb208ef855c969f4fULL, 0xbdbd2d335e51a935ULL }, { 0xde8b2b66b3bc4723ULL, 0xad2c788035e61382ULL },
+	{ 0x8b16fb203055ac76ULL, 0x4c3bcb5021afcc31ULL }, { 0xaddcb9e83c6b1793ULL, 0xdf4abe242a1bbf3dULL },
+	{ 0xd953e8624b85dd78ULL, 0xd71d6dad34a2af0dULL }, { 0x87d4713d6f33aa6bULL, 0x8672648c40e5ad68ULL },
+	{ 0xa9c98d8ccb009506ULL, 0x680efdaf511f18c2ULL }, { 0xd43bf0effdc0ba48ULL, 0x0212bd1b2566def2ULL },
+	{ 0x84a57695fe98746dULL, 0x014bb630f7604b57ULL }, { 0xa5ced43b7e3e9188ULL, 0x419ea3bd35385e2dULL },
+	{ 0xcf42894a5dce35eaULL, 0x52064cac828675b9ULL }, { 0x818995ce7aa0e1b2ULL, 0x7343efebd1940993ULL },
+	{ 0xa1ebfb4219491a1fULL, 0x1014ebe6c5f90bf8ULL }, { 0xca66fa129f9b60a6ULL, 0xd41a26e077774ef6ULL },
+	{ 0xfd00b897478238d0ULL, 0x8920b098955522b4ULL }, { 0x9e20735e8cb16382ULL, 0x55b46e5f5d5535b0ULL },
+	{ 0xc5a890362fddbc62ULL, 0xeb2189f734aa831dULL }, { 0xf712b443bbd52b7bULL, 0xa5e9ec7501d523e4ULL },
+	{ 0x9a6bb0aa55653b2dULL, 0x47b233c92125366eULL }, { 0xc1069cd4eabe89f8ULL, 0x999ec0bb696e840aULL },
+	{ 0xf148440a256e2c76ULL, 0xc00670ea43ca250dULL }, { 0x96cd2a865764dbcaULL, 0x380406926a5e5728ULL },
+	{ 0xbc807527ed3e12bcULL, 0xc605083704f5ecf2ULL }, { 0xeba09271e88d976bULL, 0xf7864a44c633682eULL },
+	{ 0x93445b8731587ea3ULL, 0x7ab3ee6afbe0211dULL }, { 0xb8157268fdae9e4cULL, 0x5960ea05bad82964ULL },
+	{ 0xe61acf033d1a45dfULL, 0x6fb92487298e33bdULL }, { 0x8fd0c16206306babULL, 0xa5d3b6d479f8e056ULL },
+	{ 0xb3c4f1ba87bc8696ULL, 0x8f48a4899877186cULL }, { 0xe0b62e2929aba83cULL, 0x331acdabfe94de87ULL },
+	{ 0x8c71dcd9ba0b4925ULL, 0x9ff0c08b7f1d0b14ULL }, { 0xaf8e5410288e1b6fULL, 0x07ecf0ae5ee44dd9ULL },
+	{ 0xdb71e91432b1a24aULL, 0xc9e82cd9f69d6150ULL }, { 0x892731ac9faf056eULL, 0xbe311c083a225cd2ULL },
+	{ 0xab70fe17c79ac6caULL, 0x6dbd630a48aaf406ULL }, { 0xd64d3d9db981787dULL, 0x092cbbccdad5b108ULL },
+	{ 0x85f0468293f0eb4eULL, 0x25bbf56008c58ea5ULL }, { 0xa76c582338ed2621ULL, 0xaf2af2b80af6f24eULL },
+	{ 0xd1476e2c07286faaULL, 0x1af5af660db4aee1ULL }, { 0x82cca4db847945caULL, 0x50d98d9fc890ed4dULL },
+	{ 0xa37fce126597973cULL, 0xe50ff107bab528a0ULL }, { 0xcc5fc196fefd7d0cULL, 0x1e53ed49a96272c8ULL },
+	{ 0xff77b1fcbebcdc4fULL, 0x25e8e89c13bb0f7aULL }, { 0x9faacf3df73609b1ULL, 0x77b191618c54e9acULL },
+	{ 0xc795830d75038c1dULL, 0xd59df5b9ef6a2417ULL }, { 0xf97ae3d0d2446f25ULL, 0x4b0573286b44ad1dULL },
+	{ 0x9becce62836ac577ULL, 0x4ee367f9430aec32ULL }, { 0xc2e801fb244576d5ULL, 0x229c41f793cda73fULL },
+	{ 0xf3a20279ed56d48aULL, 0x6b43527578c1110fULL }, { 0x9845418c345644d6ULL, 0x830a13896b78aaa9ULL },
+	{ 0xbe5691ef416bd60cULL, 0x23cc986bc656d553ULL }, { 0xedec366b11c6cb8fULL, 0x2cbfbe86b7ec8aa8ULL },
+	{ 0x94b3a202eb1c3f39ULL, 0x7bf7d71432f3d6a9ULL }, { 0xb9e08a83a5e34f07ULL, 0xdaf5ccd93fb0cc53ULL },
+	{ 0xe858ad248f5c22c9ULL, 0xd1b3400f8f9cff68ULL }, { 0x91376c36d99995beULL, 0x23100809b9c21fa1ULL },
+	{ 0xb58547448ffffb2dULL, 0xabd40a0c2832a78aULL }, { 0xe2e69915b3fff9f9ULL, 0x16c90c8f323f516cULL },
+	{ 0x8dd01fad907ffc3bULL, 0xae3da7d97f6792e3ULL }, { 0xb1442798f49ffb4aULL, 0x99cd11cfdf41779cULL },
+	{ 0xdd95317f31c7fa1dULL, 0x40405643d711d583ULL }, { 0x8a7d3eef7f1cfc52ULL, 0x482835ea666b2572ULL },
+	{ 0xad1c8eab5ee43b66ULL, 0xda3243650005eecfULL }, { 0xd863b256369d4a40ULL, 0x90bed43e40076a82ULL },
+	{ 0x873e4f75e2224e68ULL, 0x5a7744a6e804a291ULL }, { 0xa90de3535aaae202ULL, 0x711515d0a205cb36ULL },
+	{ 0xd3515c2831559a83ULL, 0x0d5a5b44ca873e03ULL }, { 0x8412d9991ed58091ULL, 0xe858790afe9486c2ULL },
+	{ 0xa5178fff668ae0b6ULL, 0x626e974dbe39a872ULL }, { 0xce5d73ff402d98e3ULL, 0xfb0a3d212dc8128fULL },
+	{ 0x80fa687f881c7f8eULL, 0x7ce66634bc9d0b99ULL }, { 0xa139029f6a239f72ULL, 0x1c1fffc1ebc44e80ULL },
+	{ 0xc987434744ac874eULL, 0xa327ffb266b56220ULL }, { 0xfbe9141915d7a922ULL, 0x4bf1ff9f0062baa8ULL },
+	{ 0x9d71ac8fada6c9b5ULL, 0x6f773fc3603db4a9ULL }, { 0xc4ce17b399107c22ULL, 0xcb550fb4384d21d3ULL },
+	{ 0xf6019da07f549b2bULL, 0x7e2a53a146606a48ULL }, { 0x99c102844f94e0fbULL, 0x2eda7444cbfc426dULL },
+	{ 0xc0314325637a1939ULL, 0xfa911155fefb5308ULL }, { 0xf03d93eebc589f88ULL, 0x793555ab7eba27caULL },
+	{ 0x96267c7535b763b5ULL, 0x4bc1558b2f3458deULL }, { 0xbbb01b9283253ca2ULL, 0x9eb1aaedfb016f16ULL },
+	{ 0xea9c227723ee8bcbULL, 0x465e15a979c1cadcULL }, { 0x92a1958a7675175fULL, 0x0bfacd89ec191ec9ULL },
+	{ 0xb749faed14125d36ULL, 0xcef980ec671f667bULL }, { 0xe51c79a85916f484ULL, 0x82b7e12780e7401aULL },
+	{ 0x8f31cc0937ae58d2ULL, 0xd1b2ecb8b0908810ULL }, { 0xb2fe3f0b8599ef07ULL, 0x861fa7e6dcb4aa15ULL },
+	{ 0xdfbdcece67006ac9ULL, 0x67a791e093e1d49aULL }, { 0x8bd6a141006042bdULL, 0xe0c8bb2c5c6d24e0ULL },
+	{ 0xaecc49914078536dULL, 0x58fae9f773886e18ULL }, { 0xda7f5bf590966848ULL, 0xaf39a475506a899eULL },
+	{ 0x888f99797a5e012dULL, 0x6d8406c952429603ULL }, { 0xaab37fd7d8f58178ULL, 0xc8e5087ba6d33b83ULL },
+	{ 0xd5605fcdcf32e1d6ULL, 0xfb1e4a9a90880a64ULL }, { 0x855c3be0a17fcd26ULL, 0x5cf2eea09a55067fULL },
+	{ 0xa6b34ad8c9dfc06fULL, 0xf42faa48c0ea481eULL }, { 0xd0601d8efc57b08bULL, 0xf13b94daf124da26ULL },
+	{ 0x823c12795db6ce57ULL, 0x76c53d08d6b70858ULL }, { 0xa2cb1717b52481edULL, 0x54768c4b0c64ca6eULL },
+	{ 0xcb7ddcdda26da268ULL, 0xa9942f5dcf7dfd09ULL }, { 0xfe5d54150b090b02ULL, 0xd3f93b35435d7c4cULL },
+	{ 0x9efa548d26e5a6e1ULL, 0xc47bc5014a1a6dafULL }, { 0xc6b8e9b0709f109aULL, 0x359ab6419ca1091bULL },
+	{ 0xf867241c8cc6d4c0ULL, 0xc30163d203c94b62ULL }, { 0x9b407691d7fc44f8ULL, 0x79e0de63425dcf1dULL },
+	{ 0xc21094364dfb5636ULL, 0x985915fc12f542e4ULL }, { 0xf294b943e17a2bc4ULL, 0x3e6f5b7b17b2939dULL },
+	{ 0x979cf3ca6cec5b5aULL, 0xa705992ceecf9c42ULL }, { 0xbd8430bd08277231ULL, 0x50c6ff782a838353ULL },
+	{ 0xece53cec4a314ebdULL, 0xa4f8bf5635246428ULL }, { 0x940f4613ae5ed136ULL, 0x871b7795e136be99ULL },
+	{ 0xb913179899f68584ULL, 0x28e2557b59846e3fULL }, { 0xe757dd7ec07426e5ULL, 0x331aeada2fe589cfULL },
+	{ 0x9096ea6f3848984fULL, 0x3ff0d2c85def7621ULL }, { 0xb4bca50b065abe63ULL, 0x0fed077a756b53a9ULL },
+	{ 0xe1ebce4dc7f16dfbULL, 0xd3e8495912c62894ULL }, { 0x8d3360f09cf6e4bdULL, 0x64712dd7abbbd95cULL },
+	{ 0xb080392cc4349decULL, 0xbd8d794d96aacfb3ULL }, { 0xdca04777f541c567ULL, 0xecf0d7a0fc5583a0ULL },
+	{ 0x89e42caaf9491b60ULL, 0xf41686c49db57244ULL }, { 0xac5d37d5b79b6239ULL, 0x311c2875c522ced5ULL },
+	{ 0xd77485cb25823ac7ULL, 0x7d633293366b828bULL }, { 0x86a8d39ef77164bcULL, 0xae5dff9c02033197ULL },
+	{ 0xa8530886b54dbdebULL, 0xd9f57f830283fdfcULL }, { 0xd267caa862a12d66ULL, 0xd072df63c324fd7bULL },
+	{ 0x8380dea93da4bc60ULL, 0x4247cb9e59f71e6dULL }, { 0xa46116538d0deb78ULL, 0x52d9be85f074e608ULL },
+	{ 0xcd795be870516656ULL, 0x67902e276c921f8bULL }, { 0x806bd9714632dff6ULL, 0x00ba1cd8a3db53b6ULL },
+	{ 0xa086cfcd97bf97f3ULL, 0x80e8a40eccd228a4ULL }, { 0xc8a883c0fdaf7df0ULL, 0x6122cd128006b2cdULL },
+	{ 0xfad2a4b13d1b5d6cULL, 0x796b805720085f81ULL }, { 0x9cc3a6eec6311a63ULL, 0xcbe3303674053bb0ULL },
+	{ 0xc3f490aa77bd60fcULL, 0xbedbfc4411068a9cULL }, { 0xf4f1b4d515acb93bULL, 0xee92fb5515482d44ULL },
+	{ 0x991711052d8bf3c5ULL, 0x751bdd152d4d1c4aULL }, { 0xbf5cd54678eef0b6ULL, 0xd262d45a78a0635dULL },
+	{ 0xef340a98172aace4ULL, 0x86fb897116c87c34ULL }, { 0x9580869f0e7aac0eULL, 0xd45d35e6ae3d4da0ULL },
+	{ 0xbae0a846d2195712ULL, 0x8974836059cca109ULL }, { 0xe998d258869facd7ULL, 0x2bd1a438703fc94bULL },
+	{ 0x91ff83775423cc06ULL, 0x7b6306a34627ddcfULL }, { 0xb67f6455292cbf08ULL, 0x1a3bc84c17b1d542ULL },
+	{ 0xe41f3d6a7377eecaULL, 0x20caba5f1d9e4a93ULL }, { 0x8e938662882af53eULL, 0x547eb47b7282ee9cULL },
+	{ 0xb23867fb2a35b28dULL, 0xe99e619a4f23aa43ULL }, { 0xdec681f9f4c31f31ULL, 0x6405fa00e2ec94d4ULL },
+	{ 0x8b3c113c38f9f37eULL, 0xde83bc408dd3dd04ULL }, { 0xae0b158b4738705eULL, 0x9624ab50b148d445ULL },
+	{ 0xd98ddaee19068c76ULL, 0x3badd624dd9b0957ULL }, { 0x87f8a8d4cfa417c9ULL, 0xe54ca5d70a80e5d6ULL },
+	{ 0xa9f6d30a038d1dbcULL, 0x5e9fcf4ccd211f4cULL }, { 0xd47487cc8470652bULL, 0x7647c3200069671fULL },
+	{ 0x84c8d4dfd2c63f3bULL, 0x29ecd9f40041e073ULL }, { 0xa5fb0a17c777cf09ULL, 0xf468107100525890ULL },
+	{ 0xcf79cc9db955c2ccULL, 0x7182148d4066eeb4ULL }, { 0x81ac1fe293d599bfULL, 0xc6f14cd848405530ULL },
+	{ 0xa21727db38cb002fULL, 0xb8ada00e5a506a7cULL }, { 0xca9cf1d206fdc03bULL, 0xa6d90811f0e4851cULL },
+	{ 0xfd442e4688bd304aULL, 0x908f4a166d1da663ULL }, { 0x9e4a9cec15763e2eULL, 0x9a598e4e043287feULL },
+	{ 0xc5dd44271ad3cdbaULL, 0x40eff1e1853f29fdULL }, { 0xf7549530e188c128ULL, 0xd12bee59e68ef47cULL },
+	{ 0x9a94dd3e8cf578b9ULL, 0x82bb74f8301958ceULL }, { 0xc13a148e3032d6e7ULL, 0xe36a52363c1faf01ULL },
+	{ 0xf18899b1bc3f8ca1ULL, 0xdc44e6c3cb279ac1ULL }, { 0x96f5600f15a7b7e5ULL, 0x29ab103a5ef8c0b9ULL },
+	{ 0xbcb2b812db11a5deULL, 0x7415d448f6b6f0e7ULL }, { 0xebdf661791d60f56ULL, 0x111b495b3464ad21ULL },
+	{ 0x936b9fcebb25c995ULL, 0xcab10dd900beec34ULL }, { 0xb84687c269ef3bfbULL, 0x3d5d514f40eea742ULL },
+	{ 0xe65829b3046b0afaULL, 0x0cb4a5a3112a5112ULL }, { 0x8ff71a0fe2c2e6dcULL, 0x47f0e785eaba72abULL },
+	{ 0xb3f4e093db73a093ULL, 0x59ed216765690f56ULL }, { 0xe0f218b8d25088b8ULL, 0x306869c13ec3532cULL },
+	{ 0x8c974f7383725573ULL, 0x1e414218c73a13fbULL }, { 0xafbd2350644eeacfULL, 0xe5d1929ef90898faULL },
+	{ 0xdbac6c247d62a583ULL, 0xdf45f746b74abf39ULL }, { 0x894bc396ce5da772ULL, 0x6b8bba8c328eb783ULL },
+	{ 0xab9eb47c81f5114fULL, 0x066ea92f3f326564ULL }, { 0xd686619ba27255a2ULL, 0xc80a537b0efefebdULL },
+	{ 0x8613fd0145877585ULL, 0xbd06742ce95f5f36ULL }, { 0xa798fc4196e952e7ULL, 0x2c48113823b73704ULL },
+	{ 0xd17f3b51fca3a7a0ULL, 0xf75a15862ca504c5ULL }, { 0x82ef85133de648c4ULL, 0x9a984d73dbe722fbULL },
+	{ 0xa3ab66580d5fdaf5ULL, 0xc13e60d0d2e0ebbaULL }, { 0xcc963fee10b7d1b3ULL, 0x318df905079926a8ULL },
+	{ 0xffbbcfe994e5c61fULL, 0xfdf17746497f7052ULL }, { 0x9fd561f1fd0f9bd3ULL, 0xfeb6ea8bedefa633ULL },
+	{ 0xc7caba6e7c5382c8ULL, 0xfe64a52ee96b8fc0ULL }, { 0xf9bd690a1b68637bULL, 0x3dfdce7aa3c673b0ULL },
+	{ 0x9c1661a651213e2dULL, 0x06bea10ca65c084eULL }, { 0xc31bfa0fe5698db8ULL, 0x486e494fcff30a62ULL },
+	{ 0xf3e2f893dec3f126ULL, 0x5a89dba3c3efccfaULL }, { 0x986ddb5c6b3a76b7ULL, 0xf89629465a75e01cULL },
+	{ 0xbe89523386091465ULL, 0xf6bbb397f1135823ULL }, { 0xee2ba6c0678b597fULL, 0x746aa07ded582e2cULL },
+	{ 0x94db483840b717efULL, 0xa8c2a44eb4571cdcULL }, { 0xba121a4650e4ddebULL, 0x92f34d62616ce413ULL },
+	{ 0xe896a0d7e51e1566ULL, 0x77b020baf9c81d17ULL }, { 0x915e2486ef32cd60ULL, 0x0ace1474dc1d122eULL },
+	{ 0xb5b5ada8aaff80b8ULL, 0x0d819992132456baULL }, { 0xe3231912d5bf60e6ULL, 0x10e1fff697ed6c69ULL },
+	{ 0x8df5efabc5979c8fULL, 0xca8d3ffa1ef463c1ULL }, { 0xb1736b96b6fd83b3ULL, 0xbd308ff8a6b17cb2ULL },
+	{ 0xddd0467c64bce4a0ULL, 0xac7cb3f6d05ddbdeULL }, { 0x8aa22c0dbef60ee4ULL, 0x6bcdf07a423aa96bULL },
+	{ 0xad4ab7112eb3929dULL, 0x86c16c98d2c953c6ULL }, { 0xd89d64d57a607744ULL, 0xe871c7bf077ba8b7ULL },
+	{ 0x87625f056c7c4a8bULL, 0x11471cd764ad4972ULL }, { 0xa93af6c6c79b5d2dULL, 0xd598e40d3dd89bcfULL },
+	{ 0xd389b47879823479ULL, 0x4aff1d108d4ec2c3ULL }, { 0x843610cb4bf160cbULL, 0xcedf722a585139baULL },
+	{ 0xa54394fe1eedb8feULL, 0xc2974eb4ee658828ULL }, { 0xce947a3da6a9273eULL, 0x733d226229feea32ULL },
+	{ 0x811ccc668829b887ULL, 0x0806357d5a3f525fULL }, { 0xa163ff802a3426a8ULL, 0xca07c2dcb0cf26f7ULL },
+	{ 0xc9bcff6034c13052ULL, 0xfc89b393dd02f0b5ULL }, { 0xfc2c3f3841f17c67ULL, 0xbbac2078d443ace2ULL },
+	{ 0x9d9ba7832936edc0ULL, 0xd54b944b84aa4c0dULL }, { 0xc5029163f384a931ULL, 0x0a9e795e65d4df11ULL },
+	{ 0xf64335bcf065d37dULL, 0x4d4617b5ff4a16d5ULL }, { 0x99ea0196163fa42eULL, 0x504bced1bf8e4e45ULL },
+	{ 0xc06481fb9bcf8d39ULL, 0xe45ec2862f71e1d6ULL }, { 0xf07da27a82c37088ULL, 0x5d767327bb4e5a4cULL },
+	{ 0x964e858c91ba2655ULL, 0x3a6a07f8d510f86fULL }, { 0xbbe226efb628afeaULL, 0x890489f70a55368bULL },
+	{ 0xeadab0aba3b2dbe5ULL, 0x2b45ac74ccea842eULL }, { 0x92c8ae6b464fc96fULL, 0x3b0b8bc90012929dULL },
+	{ 0xb77ada0617e3bbcbULL, 0x09ce6ebb40173744ULL }, { 0xe55990879ddcaabdULL, 0xcc420a6a101d0515ULL },
+	{ 0x8f57fa54c2a9eab6ULL, 0x9fa946824a12232dULL }, { 0xb32df8e9f3546564ULL, 0x47939822dc96abf9ULL },
+	{ 0xdff9772470297ebdULL, 0x59787e2b93bc56f7ULL }, { 0x8bfbea76c619ef36ULL, 0x57eb4edb3c55b65aULL },
+	{ 0xaefae51477a06b03ULL, 0xede622920b6b23f1ULL }, { 0xdab99e59958885c4ULL, 0xe95fab368e45ecedULL },
+	{ 0x88b402f7fd75539bULL, 0x11dbcb0218ebb414ULL }, { 0xaae103b5fcd2a881ULL, 0xd652bdc29f26a119ULL },
+	{ 0xd59944a37c0752a2ULL, 0x4be76d3346f0495fULL }, { 0x857fcae62d8493a5ULL, 0x6f70a4400c562ddbULL },
+	{ 0xa6dfbd9fb8e5b88eULL, 0xcb4ccd500f6bb952ULL }, { 0xd097ad07a71f26b2ULL, 0x7e2000a41346a7a7ULL },
+	{ 0x825ecc24c873782fULL, 0x8ed400668c0c28c8ULL }, { 0xa2f67f2dfa90563bULL, 0x728900802f0f32faULL },
+	{ 0xcbb41ef979346bcaULL, 0x4f2b40a03ad2ffb9ULL }, { 0xfea126b7d78186bcULL, 0xe2f610c84987bfa8ULL },
+	{ 0x9f24b832e6b0f436ULL, 0x0dd9ca7d2df4d7c9ULL }, { 0xc6ede63fa05d3143ULL, 0x91503d1c79720dbbULL },
+	{ 0xf8a95fcf88747d94ULL, 0x75a44c6397ce912aULL }, { 0x9b69dbe1b548ce7cULL, 0xc986afbe3ee11abaULL },
+	{ 0xc24452da229b021bULL, 0xfbe85badce996168ULL }, { 0xf2d56790ab41c2a2ULL, 0xfae27299423fb9c3ULL },
+	{ 0x97c560ba6b0919a5ULL, 0xdccd879fc967d41aULL }, { 0xbdb6b8e905cb600fULL, 0x5400e987bbc1c920ULL },
+	{ 0xed246723473e3813ULL, 0x290123e9aab23b68ULL }, { 0x9436c0760c86e30bULL, 0xf9a0b6720aaf6521ULL },
+	{ 0xb94470938fa89bceULL, 0xf808e40e8d5b3e69ULL }, { 0xe7958cb87392c2c2ULL, 0xb60b1d1230b20e04ULL },
+	{ 0x90bd77f3483bb9b9ULL, 0xb1c6f22b5e6f48c2ULL }, { 0xb4ecd5f01a4aa828ULL, 0x1e38aeb6360b1af3ULL },
+	{ 0xe2280b6c20dd5232ULL, 0x25c6da63c38de1b0ULL }, { 0x8d590723948a535fULL, 0x579c487e5a38ad0eULL },
+	{ 0xb0af48ec79ace837ULL, 0x2d835a9df0c6d851ULL }, { 0xdcdb1b2798182244ULL, 0xf8e431456cf88e65ULL },
+	{ 0x8a08f0f8bf0f156bULL, 0x1b8e9ecb641b58ffULL }, { 0xac8b2d36eed2dac5ULL, 0xe272467e3d222f3fULL },
+	{ 0xd7adf884aa879177ULL, 0x5b0ed81dcc6abb0fULL }, { 0x86ccbb52ea94baeaULL, 0x98e947129fc2b4e9ULL },
+	{ 0xa87fea27a539e9a5ULL, 0x3f2398d747b36224ULL }, { 0xd29fe4b18e88640eULL, 0x8eec7f0d19a03aadULL },
+	{ 0x83a3eeeef9153e89ULL, 0x1953cf68300424acULL }, { 0xa48ceaaab75a8e2bULL, 0x5fa8c3423c052dd7ULL },
+	{ 0xcdb02555653131b6ULL, 0x3792f412cb06794dULL }, { 0x808e17555f3ebf11ULL, 0xe2bbd88bbee40bd0ULL },
+	{ 0xa0b19d2ab70e6ed6ULL, 0x5b6aceaeae9d0ec4ULL }, { 0xc8de047564d20a8bULL, 0xf245825a5a445275ULL },
+	{ 0xfb158592be068d2eULL, 0xeed6e2f0f0d56712ULL }, { 0x9ced737bb6c4183dULL, 0x55464dd69685606bULL },
+	{ 0xc428d05aa4751e4cULL, 0xaa97e14c3c26b886ULL }, { 0xf53304714d9265dfULL, 0xd53dd99f4b3066a8ULL },
+	{ 0x993fe2c6d07b7fabULL, 0xe546a8038efe4029ULL }, { 0xbf8fdb78849a5f96ULL, 0xde98520472bdd033ULL },
+	{ 0xef73d256a5c0f77cULL, 0x963e66858f6d4440ULL }, { 0x95a8637627989aadULL, 0xdde7001379a44aa8ULL },
+	{ 0xbb127c53b17ec159ULL, 0x5560c018580d5d52ULL }, { 0xe9d71b689dde71afULL, 0xaab8f01e6e10b4a6ULL },
+	{ 0x9226712162ab070dULL, 0xcab3961304ca70e8ULL }, { 0xb6b00d69bb55c8d1ULL, 0x3d607b97c5fd0d22ULL },
+	{ 0xe45c10c42a2b3b05ULL, 0x8cb89a7db77c506aULL }, { 0x8eb98a7a9a5b04e3ULL, 0x77f3608e92adb242ULL },
+	{ 0xb267ed1940f1c61cULL, 0x55f038b237591ed3ULL }, { 0xdf01e85f912e37a3ULL, 0x6b6c46dec52f6688ULL },
+	{ 0x8b61313bbabce2c6ULL, 0x2323ac4b3b3da015ULL }, { 0xae397d8aa96c1b77ULL, 0xabec975e0a0d081aULL },
+	{ 0xd9c7dced53c72255ULL, 0x96e7bd358c904a21ULL }, { 0x881cea14545c7575ULL, 0x7e50d64177da2e54ULL },
+	{ 0xaa242499697392d2ULL, 0xdde50bd1d5d0b9e9ULL }, { 0xd4ad2dbfc3d07787ULL, 0x955e4ec64b44e864ULL },
+	{ 0x84ec3c97da624ab4ULL, 0xbd5af13bef0b113eULL }, { 0xa6274bbdd0fadd61ULL, 0xecb1ad8aeacdd58eULL },
+	{ 0xcfb11ead453994baULL, 0x67de18eda5814af2ULL }, { 0x81ceb32c4b43fcf4ULL, 0x80eacf948770ced7ULL },
+	{ 0xa2425ff75e14fc31ULL, 0xa1258379a94d028dULL }, { 0xcad2f7f5359a3b3eULL, 0x096ee45813a04330ULL },
+	{ 0xfd87b5f28300ca0dULL, 0x8bca9d6e188853fcULL }, { 0x9e74d1b791e07e48ULL, 0x775ea264cf55347dULL },
+	{ 0xc612062576589ddaULL, 0x95364afe032a819dULL }, { 0xf79687aed3eec551ULL, 0x3a83ddbd83f52204ULL },
+	{ 0x9abe14cd44753b52ULL, 0xc4926a9672793542ULL }, { 0xc16d9a0095928a27ULL, 0x75b7053c0f178293ULL },
+	{ 0xf1c90080baf72cb1ULL, 0x5324c68b12dd6338ULL }, { 0x971da05074da7beeULL, 0xd3f6fc16ebca5e03ULL },
+	{ 0xbce5086492111aeaULL, 0x88f4bb1ca6bcf584ULL }, { 0xec1e4a7db69561a5ULL, 0x2b31e9e3d06c32e5ULL },
+	{ 0x9392ee8e921d5d07ULL, 0x3aff322e62439fcfULL }, { 0xb877aa3236a4b449ULL, 0x09befeb9fad487c2ULL },
+	{ 0xe69594bec44de15bULL, 0x4c2ebe687989a9b3ULL }, { 0x901d7cf73ab0acd9ULL, 0x0f9d37014bf60a10ULL },
+	{ 0xb424dc35095cd80fULL, 0x538484c19ef38c94ULL }, { 0xe12e13424bb40e13ULL, 0x2865a5f206b06fb9ULL },
+	{ 0x8cbccc096f5088cbULL, 0xf93f87b7442e45d3ULL }, { 0xafebff0bcb24aafeULL, 0xf78f69a51539d748ULL },
+	{ 0xdbe6fecebdedd5beULL, 0xb573440e5a884d1bULL }, { 0x89705f4136b4a597ULL, 0x31680a88f8953030ULL },
+	{ 0xabcc77118461cefcULL, 0xfdc20d2b36ba7c3dULL }, { 0xd6bf94d5e57a42bcULL, 0x3d32907604691b4cULL },
+	{ 0x8637bd05af6c69b5ULL, 0xa63f9a49c2c1b10fULL }, { 0xa7c5ac471b478423ULL, 0x0fcf80dc33721d53ULL },
+	{ 0xd1b71758e219652bULL, 0xd3c36113404ea4a8ULL }, { 0x83126e978d4fdf3bULL, 0x645a1cac083126e9ULL },
+	{ 0xa3d70a3d70a3d70aULL, 0x3d70a3d70a3d70a3ULL }, { 0xccccccccccccccccULL, 0xccccccccccccccccULL },
+	{ 0x8000000000000000ULL, 0x0000000000000000ULL }, { 0xa000000000000000ULL, 0x0000000000000000ULL },
+	{ 0xc800000000000000ULL, 0x0000000000000000ULL }, { 0xfa00000000000000ULL, 0x0000000000000000ULL },
+	{ 0x9c40000000000000ULL, 0x0000000000000000ULL }, { 0xc350000000000000ULL, 0x0000000000000000ULL },
+	{ 0xf424000000000000ULL, 0x0000000000000000ULL }, { 0x9896800000000000ULL, 0x0000000000000000ULL },
+	{ 0xbebc200000000000ULL, 0x0000000000000000ULL }, { 0xee6b280000000000ULL, 0x0000000000000000ULL },
+	{ 0x9502f90000000000ULL, 0x0000000000000000ULL }, { 0xba43b74000000000ULL, 0x0000000000000000ULL },
+	{ 0xe8d4a51000000000ULL, 0x0000000000000000ULL }, { 0x9184e72a00000000ULL, 0x0000000000000000ULL },
+	{ 0xb5e620f480000000ULL, 0x0000000000000000ULL }, { 0xe35fa931a0000000ULL, 0x0000000000000000ULL },
+	{ 0x8e1bc9bf04000000ULL, 0x0000000000000000ULL }, { 0xb1a2bc2ec5000000ULL, 0x0000000000000000ULL },
+	{ 0xde0b6b3a76400000ULL, 0x0000000000000000ULL }, { 0x8ac7230489e80000ULL, 0x0000000000000000ULL },
+	{ 0xad78ebc5ac620000ULL, 0x0000000000000000ULL }, { 0xd8d726b7177a8000ULL, 0x0000000000000000ULL },
+	{ 0x878678326eac9000ULL, 0x0000000000000000ULL }, { 0xa968163f0a57b400ULL, 0x0000000000000000ULL },
+	{ 0xd3c21bcecceda100ULL, 0x0000000000000000ULL }, { 0x84595161401484a0ULL, 0x0000000000000000ULL },
+	{ 0xa56fa5b99019a5c8ULL, 0x0000000000000000ULL }, { 0xcecb8f27f4200f3aULL, 0x0000000000000000ULL },
+	{ 0x813f3978f8940984ULL, 0x4000000000000000ULL }, { 0xa18f07d736b90be5ULL, 0x5000000000000000ULL },
+	{ 0xc9f2c9cd04674edeULL, 0xa400000000000000ULL }, { 0xfc6f7c4045812296ULL, 0x4d00000000000000ULL },
+	{ 0x9dc5ada82b70b59dULL, 0xf020000000000000ULL }, { 0xc5371912364ce305ULL, 0x6c28000000000000ULL },
+	{ 0xf684df56c3e01bc6ULL, 0xc732000000000000ULL }, { 0x9a130b963a6c115cULL, 0x3c7f400000000000ULL },
+	{ 0xc097ce7bc90715b3ULL, 0x4b9f100000000000ULL }, { 0xf0bdc21abb48db20ULL, 0x1e86d40000000000ULL },
+	{ 0x96769950b50d88f4ULL, 0x1314448000000000ULL }, { 0xbc143fa4e250eb31ULL, 0x17d955a000000000ULL },
+	{ 0xeb194f8e1ae525fdULL, 0x5dcfab0800000000ULL }, { 0x92efd1b8d0cf37beULL, 0x5aa1cae500000000ULL },
+	{ 0xb7abc627050305adULL, 0xf14a3d9e40000000ULL }, { 0xe596b7b0c643c719ULL, 0x6d9ccd05d0000000ULL },
+	{ 0x8f7e32ce7bea5c6fULL, 0xe4820023a2000000ULL }, { 0xb35dbf821ae4f38bULL, 0xdda2802c8a800000ULL },
+	{ 0xe0352f62a19e306eULL, 0xd50b2037ad200000ULL }, { 0x8c213d9da502de45ULL, 0x4526f422cc340000ULL },
+	{ 0xaf298d050e4395d6ULL, 0x9670b12b7f410000ULL }, { 0xdaf3f04651d47b4cULL, 0x3c0cdd765f114000ULL },
+	{ 0x88d8762bf324cd0fULL, 0xa5880a69fb6ac800ULL }, { 0xab0e93b6efee0053ULL, 0x8eea0d047a457a00ULL },
+	{ 0xd5d238a4abe98068ULL, 0x72a4904598d6d880ULL }, { 0x85a36366eb71f041ULL, 0x47a6da2b7f864750ULL },
+	{ 0xa70c3c40a64e6c51ULL, 0x999090b65f67d924ULL }, { 0xd0cf4b50cfe20765ULL, 0xfff4b4e3f741cf6dULL },
+	{ 0x82818f1281ed449fULL, 0xbff8f10e7a8921a4ULL }, { 0xa321f2d7226895c7ULL, 0xaff72d52192b6a0dULL },
+	{ 0xcbea6f8ceb02bb39ULL, 0x9bf4f8a69f764490ULL }, { 0xfee50b7025c36a08ULL, 0x02f236d04753d5b4ULL },
+	{ 0x9f4f2726179a2245ULL, 0x01d762422c946590ULL }, { 0xc722f0ef9d80aad6ULL, 0x424d3ad2b7b97ef5ULL },
+	{ 0xf8ebad2b84e0d58bULL, 0xd2e0898765a7deb2ULL }, { 0x9b934c3b330c8577ULL, 0x63cc55f49f88eb2fULL },
+	{ 0xc2781f49ffcfa6d5ULL, 0x3cbf6b71c76b25fbULL }, { 0xf316271c7fc3908aULL, 0x8bef464e3945ef7aULL },
+	{ 0x97edd871cfda3a56ULL, 0x97758bf0e3cbb5acULL }, { 0xbde94e8e43d0c8ecULL, 0x3d52eeed1cbea317ULL },
+	{ 0xed63a231d4c4fb27ULL, 0x4ca7aaa863ee4bddULL }, { 0x945e455f24fb1cf8ULL, 0x8fe8caa93e74ef6aULL },
+	{ 0xb975d6b6ee39e436ULL, 0xb3e2fd538e122b44ULL }, { 0xe7d34c64a9c85d44ULL, 0x60dbbca87196b616ULL },
+	{ 0x90e40fbeea1d3a4aULL, 0xbc8955e946fe31cdULL }, { 0xb51d13aea4a488ddULL, 0x6babab6398bdbe41ULL },
+	{ 0xe264589a4dcdab14ULL, 0xc696963c7eed2dd1ULL }, { 0x8d7eb76070a08aecULL, 0xfc1e1de5cf543ca2ULL },
+	{ 0xb0de65388cc8ada8ULL, 0x3b25a55f43294bcbULL }, { 0xdd15fe86affad912ULL, 0x49ef0eb713f39ebeULL },
+	{ 0x8a2dbf142dfcc7abULL, 0x6e3569326c784337ULL }, { 0xacb92ed9397bf996ULL, 0x49c2c37f07965404ULL },
+	{ 0xd7e77a8f87daf7fbULL, 0xdc33745ec97be906ULL }, { 0x86f0ac99b4e8dafdULL, 0x69a028bb3ded71a3ULL },
+	{ 0xa8acd7c0222311bcULL, 0xc40832ea0d68ce0cULL }, { 0xd2d80db02aabd62bULL, 0xf50a3fa490c30190ULL },
+	{ 0x83c7088e1aab65dbULL, 0x792667c6da79e0faULL }, { 0xa4b8cab1a1563f52ULL, 0x577001b891185938ULL },
+	{ 0xcde6fd5e09abcf26ULL, 0xed4c0226b55e6f86ULL }, { 0x80b05e5ac60b6178ULL, 0x544f8158315b05b4ULL },
+	{ 0xa0dc75f1778e39d6ULL, 0x696361ae3db1c721ULL }, { 0xc913936dd571c84cULL, 0x03bc3a19cd1e38e9ULL },
+	{ 0xfb5878494ace3a5fULL, 0x04ab48a04065c723ULL }, { 0x9d174b2dcec0e47bULL, 0x62eb0d64283f9c76ULL },
+	{ 0xc45d1df942711d9aULL, 0x3ba5d0bd324f8394ULL }, { 0xf5746577930d6500ULL, 0xca8f44ec7ee36479ULL },
+	{ 0x9968bf6abbe85f20ULL, 0x7e998b13cf4e1ecbULL }, { 0xbfc2ef456ae276e8ULL, 0x9e3fedd8c321a67eULL },
+	{ 0xefb3ab16c59b14a2ULL, 0xc5cfe94ef3ea101eULL }, { 0x95d04aee3b80ece5ULL, 0xbba1f1d158724a12ULL },
+	{ 0xbb445da9ca61281fULL, 0x2a8a6e45ae8edc97ULL }, { 0xea1575143cf97226ULL, 0xf52d09d71a3293bdULL },
+	{ 0x924d692ca61be758ULL, 0x593c2626705f9c56ULL }, { 0xb6e0c377cfa2e12eULL, 0x6f8b2fb00c77836cULL },
+	{ 0xe498f455c38b997aULL, 0x0b6dfb9c0f956447ULL }, { 0x8edf98b59a373fecULL, 0x4724bd4189bd5eacULL },
+	{ 0xb2977ee300c50fe7ULL, 0x58edec91ec2cb657ULL }, { 0xdf3d5e9bc0f653e1ULL, 0x2f2967b66737e3edULL },
+	{ 0x8b865b215899f46cULL, 0xbd79e0d20082ee74ULL }, { 0xae67f1e9aec07187ULL, 0xecd8590680a3aa11ULL },
+	{ 0xda01ee641a708de9ULL, 0xe80e6f4820cc9495ULL }, { 0x884134fe908658b2ULL, 0x3109058d147fdcddULL },
+	{ 0xaa51823e34a7eedeULL, 0xbd4b46f0599fd415ULL }, { 0xd4e5e2cdc1d1ea96ULL, 0x6c9e18ac7007c91aULL },
+	{ 0x850fadc09923329eULL, 0x03e2cf6bc604ddb0ULL }, { 0xa6539930bf6bff45ULL, 0x84db8346b786151cULL },
+	{ 0xcfe87f7cef46ff16ULL, 0xe612641865679a63ULL }, { 0x81f14fae158c5f6eULL, 0x4fcb7e8f3f60c07eULL },
+	{ 0xa26da3999aef7749ULL, 0xe3be5e330f38f09dULL }, { 0xcb090c8001ab551cULL, 0x5cadf5bfd3072cc5ULL },
+	{ 0xfdcb4fa002162a63ULL, 0x73d9732fc7c8f7f6ULL }, { 0x9e9f11c4014dda7eULL, 0x2867e7fddcdd9afaULL },
+	{ 0xc646d63501a1511dULL, 0xb281e1fd541501b8ULL }, { 0xf7d88bc24209a565ULL, 0x1f225a7ca91a4226ULL },
+	{ 0x9ae757596946075fULL, 0x3375788de9b06958ULL }, { 0xc1a12d2fc3978937ULL, 0x0052d6b1641c83aeULL },
+	{ 0xf209787bb47d6b84ULL, 0xc0678c5dbd23a49aULL }, { 0x9745eb4d50ce6332ULL, 0xf840b7ba963646e0ULL },
+	{ 0xbd176620a501fbffULL, 0xb650e5a93bc3d898ULL }, { 0xec5d3fa8ce427affULL, 0xa3e51f138ab4cebeULL },
+	{ 0x93ba47c980e98cdfULL, 0xc66f336c36b10137ULL }, { 0xb8a8d9bbe123f017ULL, 0xb80b0047445d4184ULL },
+	{ 0xe6d3102ad96cec1dULL, 0xa60dc059157491e5ULL }, { 0x9043ea1ac7e41392ULL, 0x87c89837ad68db2fULL },
+	{ 0xb454e4a179dd1877ULL, 0x29babe4598c311fbULL }, { 0xe16a1dc9d8545e94ULL, 0xf4296dd6fef3d67aULL },
+	{ 0x8ce2529e2734bb1dULL, 0x1899e4a65f58660cULL }, { 0xb01ae745b101e9e4ULL, 0x5ec05dcff72e7f8fULL },
+	{ 0xdc21a1171d42645dULL, 0x76707543f4fa1f73ULL }, { 0x899504ae72497ebaULL, 0x6a06494a791c53a8ULL },
+	{ 0xabfa45da0edbde69ULL, 0x0487db9d17636892ULL }, { 0xd6f8d7509292d603ULL, 0x45a9d2845d3c42b6ULL },
+	{ 0x865b86925b9bc5c2ULL, 0x0b8a2392ba45a9b2ULL }, { 0xa7f26836f282b732ULL, 0x8e6cac7768d7141eULL },
+	{ 0xd1ef0244af2364ffULL, 0x3207d795430cd926ULL }, { 0x8335616aed761f1fULL, 0x7f44e6bd49e807b8ULL },
+	{ 0xa402b9c5a8d3a6e7ULL, 0x5f16206c9c6209a6ULL }, { 0xcd036837130890a1ULL, 0x36dba887c37a8c0fULL },
+	{ 0x802221226be55a64ULL, 0xc2494954da2c9789ULL }, { 0xa02aa96b06deb0fdULL, 0xf2db9baa10b7bd6cULL },
+	{ 0xc83553c5c8965d3dULL, 0x6f92829494e5acc7ULL }, { 0xfa42a8b73abbf48cULL, 0xcb772339ba1f17f9ULL },
+	{ 0x9c69a97284b578d7ULL, 0xff2a760414536efbULL }, { 0xc38413cf25e2d70dULL, 0xfef5138519684abaULL },
+	{ 0xf46518c2ef5b8cd1ULL, 0x7eb258665fc25d69ULL }, { 0x98bf2f79d5993802ULL, 0xef2f773ffbd97a61ULL },
+	{ 0xbeeefb584aff8603ULL, 0xaafb550ffacfd8faULL }, { 0xeeaaba2e5dbf6784ULL, 0x95ba2a53f983cf38ULL },
+	{ 0x952ab45cfa97a0b2ULL, 0xdd945a747bf26183ULL }, { 0xba756174393d88dfULL, 0x94f971119aeef9e4ULL },
+	{ 0xe912b9d1478ceb17ULL, 0x7a37cd5601aab85dULL }, { 0x91abb422ccb812eeULL, 0xac62e055c10ab33aULL },
+	{ 0xb616a12b7fe617aaULL, 0x577b986b314d6009ULL }, { 0xe39c49765fdf9d94ULL, 0xed5a7e85fda0b80bULL },
+	{ 0x8e41ade9fbebc27dULL, 0x14588f13be847307ULL }, { 0xb1d219647ae6b31cULL, 0x596eb2d8ae258fc8ULL },
+	{ 0xde469fbd99a05fe3ULL, 0x6fca5f8ed9aef3bbULL }, { 0x8aec23d680043beeULL, 0x25de7bb9480d5854ULL },
+	{ 0xada72ccc20054ae9ULL, 0xaf561aa79a10ae6aULL }, { 0xd910f7ff28069da4ULL, 0x1b2ba1518094da04ULL },
+	{ 0x87aa9aff79042286ULL, 0x90fb44d2f05d0842ULL }, { 0xa99541bf57452b28ULL, 0x353a1607ac744a53ULL },
+	{ 0xd3fa922f2d1675f2ULL, 0x42889b8997915ce8ULL }, { 0x847c9b5d7c2e09b7ULL, 0x69956135febada11ULL },
+	{ 0xa59bc234db398c25ULL, 0x43fab9837e699095ULL }, { 0xcf02b2c21207ef2eULL, 0x94f967e45e03f4bbULL },
+	{ 0x8161afb94b44f57dULL, 0x1d1be0eebac278f5ULL }, { 0xa1ba1ba79e1632dcULL, 0x6462d92a69731732ULL },
+	{ 0xca28a291859bbf93ULL, 0x7d7b8f7503cfdcfeULL }, { 0xfcb2cb35e702af78ULL, 0x5cda735244c3d43eULL },
+	{ 0x9defbf01b061adabULL, 0x3a0888136afa64a7ULL }, { 0xc56baec21c7a1916ULL, 0x088aaa1845b8fdd0ULL },
+	{ 0xf6c69a72a3989f5bULL, 0x8aad549e57273d45ULL }, { 0x9a3c2087a63f6399ULL, 0x36ac54e2f678864bULL },
+	{ 0xc0cb28a98fcf3c7fULL, 0x84576a1bb416a7ddULL }, { 0xf0fdf2d3f3c30b9fULL, 0x656d44a2a11c51d5ULL },
+	{ 0x969eb7c47859e743ULL, 0x9f644ae5a4b1b325ULL }, { 0xbc4665b596706114ULL, 0x873d5d9f0dde1feeULL },
+	{ 0xeb57ff22fc0c7959ULL, 0xa90cb506d155a7eaULL }, { 0x9316ff75dd87cbd8ULL, 0x09a7f12442d588f2ULL },
+	{ 0xb7dcbf5354e9beceULL, 0x0c11ed6d538aeb2fULL }, { 0xe5d3ef282a242e81ULL, 0x8f1668c8a86da5faULL },
+	{ 0x8fa475791a569d10ULL, 0xf96e017d694487bcULL }, { 0xb38d92d760ec4455ULL, 0x37c981dcc395a9acULL },
+	{ 0xe070f78d3927556aULL, 0x85bbe253f47b1417ULL }, { 0x8c469ab843b89562ULL, 0x93956d7478ccec8eULL },
+	{ 0xaf58416654a6babbULL, 0x387ac8d1970027b2ULL }, { 0xdb2e51bfe9d0696aULL, 0x06997b05fcc0319eULL },
+	{ 0x88fcf317f22241e2ULL, 0x441fece3bdf81f03ULL }, { 0xab3c2fddeeaad25aULL, 0xd527e81cad7626c3ULL },
+	{ 0xd60b3bd56a5586f1ULL, 0x8a71e223d8d3b074ULL }, { 0x85c7056562757456ULL, 0xf6872d5667844e49ULL },
+	{ 0xa738c6bebb12d16cULL, 0xb428f8ac016561dbULL }, { 0xd106f86e69d785c7ULL, 0xe13336d701beba52ULL },
+	{ 0x82a45b450226b39cULL, 0xecc0024661173473ULL }, { 0xa34d721642b06084ULL, 0x27f002d7f95d0190ULL },
+	{ 0xcc20ce9bd35c78a5ULL, 0x31ec038df7b441f4ULL }, { 0xff290242c83396ceULL, 0x7e67047175a15271ULL },
+	{ 0x9f79a169bd203e41ULL, 0x0f0062c6e984d386ULL }, { 0xc75809c42c684dd1ULL, 0x52c07b78a3e60868ULL },
+	{ 0xf92e0c3537826145ULL, 0xa7709a56ccdf8a82ULL }, { 0x9bbcc7a142b17ccbULL, 0x88a66076400bb691ULL },
+	{ 0xc2abf989935ddbfeULL, 0x6acff893d00ea435ULL }, { 0xf356f7ebf83552feULL, 0x0583f6b8c4124d43ULL },
+	{ 0x98165af37b2153deULL, 0xc3727a337a8b704aULL }, { 0xbe1bf1b059e9a8d6ULL, 0x744f18c0592e4c5cULL },
+	{ 0xeda2ee1c7064130cULL, 0x1162def06f79df73ULL }, { 0x9485d4d1c63e8be7ULL, 0x8addcb5645ac2ba8ULL },
+	{ 0xb9a74a0637ce2ee1ULL, 0x6d953e2bd7173692ULL }, { 0xe8111c87c5c1ba99ULL, 0xc8fa8db6ccdd0437ULL },
+	{ 0x910ab1d4db9914a0ULL, 0x1d9c9892400a22a2ULL }, { 0xb54d5e4a127f59c8ULL, 0x2503beb6d00cab4bULL },
+	{ 0xe2a0b5dc971f303aULL, 0x2e44ae64840fd61dULL }, { 0x8da471a9de737e24ULL, 0x5ceaecfed289e5d2ULL },
+	{ 0xb10d8e1456105dadULL, 0x7425a83e872c5f47ULL }, { 0xdd50f1996b947518ULL, 0xd12f124e28f77719ULL },
+	{ 0x8a5296ffe33cc92fULL, 0x82bd6b70d99aaa6fULL }, { 0xace73cbfdc0bfb7bULL, 0x636cc64d1001550bULL },
+	{ 0xd8210befd30efa5aULL, 0x3c47f7e05401aa4eULL }, { 0x8714a775e3e95c78ULL, 0x65acfaec34810a71ULL },
+	{ 0xa8d9d1535ce3b396ULL, 0x7f1839a741a14d0dULL }, { 0xd31045a8341ca07cULL, 0x1ede48111209a050ULL },
+	{ 0x83ea2b892091e44dULL, 0x934aed0aab460432ULL }, { 0xa4e4b66b68b65d60ULL, 0xf81da84d5617853fULL },
+	{ 0xce1de40642e3f4b9ULL, 0x36251260ab9d668eULL }, { 0x80d2ae83e9ce78f3ULL, 0xc1d72b7c6b426019ULL },
+	{ 0xa1075a24e4421730ULL, 0xb24cf65b8612f81fULL }, { 0xc94930ae1d529cfcULL, 0xdee033f26797b627ULL },
+	{ 0xfb9b7cd9a4a7443cULL, 0x169840ef017da3b1ULL }, { 0x9d412e0806e88aa5ULL, 0x8e1f289560ee864eULL },
+	{ 0xc491798a08a2ad4eULL, 0xf1a6f2bab92a27e2ULL }, { 0xf5b5d7ec8acb58a2ULL, 0xae10af696774b1dbULL },
+	{ 0x9991a6f3d6bf1765ULL, 0xacca6da1e0a8ef29ULL }, { 0xbff610b0cc6edd3fULL, 0x17fd090a58d32af3ULL },
+	{ 0xeff394dcff8a948eULL, 0xddfc4b4cef07f5b0ULL }, { 0x95f83d0a1fb69cd9ULL, 0x4abdaf101564f98eULL },
+	{ 0xbb764c4ca7a4440fULL, 0x9d6d1ad41abe37f1ULL }, { 0xea53df5fd18d5513ULL, 0x84c86189216dc5edULL },
+	{ 0x92746b9be2f8552cULL, 0x32fd3cf5b4e49bb4ULL }, { 0xb7118682dbb66a77ULL, 0x3fbc8c33221dc2a1ULL },
+	{ 0xe4d5e82392a40515ULL, 0x0fabaf3feaa5334aULL }, { 0x8f05b1163ba6832dULL, 0x29cb4d87f2a7400eULL },
+	{ 0xb2c71d5bca9023f8ULL, 0x743e20e9ef511012ULL }, { 0xdf78e4b2bd342cf6ULL, 0x914da9246b255416ULL },
+	{ 0x8bab8eefb6409c1aULL, 0x1ad089b6c2f7548eULL }, { 0xae9672aba3d0c320ULL, 0xa184ac2473b529b1ULL },
+	{ 0xda3c0f568cc4f3e8ULL, 0xc9e5d72d90a2741eULL }, { 0x8865899617fb1871ULL, 0x7e2fa67c7a658892ULL },
+	{ 0xaa7eebfb9df9de8dULL, 0xddbb901b98feeab7ULL }, { 0xd51ea6fa85785631ULL, 0x552a74227f3ea565ULL },
+	{ 0x8533285c936b35deULL, 0xd53a88958f87275fULL }, { 0xa67ff273b8460356ULL, 0x8a892abaf368f137ULL },
+	{ 0xd01fef10a657842cULL, 0x2d2b7569b0432d85ULL }, { 0x8213f56a67f6b29bULL, 0x9c3b29620e29fc73ULL },
+	{ 0xa298f2c501f45f42ULL, 0x8349f3ba91b47b8fULL }, { 0xcb3f2f7642717713ULL, 0x241c70a936219a73ULL },
+	{ 0xfe0efb53d30dd4d7ULL, 0xed238cd383aa0110ULL }, { 0x9ec95d1463e8a506ULL, 0xf4363804324a40aaULL },
+	{ 0xc67bb4597ce2ce48ULL, 0xb143c6053edcd0d5ULL }, { 0xf81aa16fdc1b81daULL, 0xdd94b7868e94050aULL },
+	{ 0x9b10a4e5e9913128ULL, 0xca7cf2b4191c8326ULL }, { 0xc1d4ce1f63f57d72ULL, 0xfd1c2f611f63a3f0ULL },
+	{ 0xf24a01a73cf2dccfULL, 0xbc633b39673c8cecULL }, { 0x976e41088617ca01ULL, 0xd5be0503e085d813ULL },
+	{ 0xbd49d14aa79dbc82ULL, 0x4b2d8644d8a74e18ULL }, { 0xec9c459d51852ba2ULL, 0xddf8e7d60ed1219eULL },
+	{ 0x93e1ab8252f33b45ULL, 0xcabb90e5c942b503ULL }, { 0xb8da1662e7b00a17ULL, 0x3d6a751f3b936243ULL },
+	{ 0xe7109bfba19c0c9dULL, 0x0cc512670a783ad4ULL }, { 0x906a617d450187e2ULL, 0x27fb2b80668b24c5ULL },
+	{ 0xb484f9dc9641e9daULL, 0xb1f9f660802dedf6ULL }, { 0xe1a63853bbd26451ULL, 0x5e7873f8a0396973ULL },
+	{ 0x8d07e33455637eb2ULL, 0xdb0b487b6423e1e8ULL }, { 0xb049dc016abc5e5fULL, 0x91ce1a9a3d2cda62ULL },
+	{ 0xdc5c5301c56b75f7ULL, 0x7641a140cc7810fbULL }, { 0x89b9b3e11b6329baULL, 0xa9e904c87fcb0a9dULL },
+	{ 0xac2820d9623bf429ULL, 0x546345fa9fbdcd44ULL }, { 0xd732290fbacaf133ULL, 0xa97c177947ad4095ULL },
+	{ 0x867f59a9d4bed6c0ULL, 0x49ed8eabcccc485dULL }, { 0xa81f301449ee8c70ULL, 0x5c68f256bfff5a74ULL },
+	{ 0xd226fc195c6a2f8cULL, 0x73832eec6fff3111ULL }, { 0x83585d8fd9c25db7ULL, 0xc831fd53c5ff7eabULL },
+	{ 0xa42e74f3d032f525ULL, 0xba3e7ca8b77f5e55ULL }, { 0xcd3a1230c43fb26fULL, 0x28ce1bd2e55f35ebULL },
+	{ 0x80444b5e7aa7cf85ULL, 0x7980d163cf5b81b3ULL }, { 0xa0555e361951c366ULL, 0xd7e105bcc332621fULL },
+	{ 0xc86ab5c39fa63440ULL, 0x8dd9472bf3fefaa7ULL }, { 0xfa856334878fc150ULL, 0xb14f98f6f0feb951ULL },
+	{ 0x9c935e00d4b9d8d2ULL, 0x6ed1bf9a569f33d3ULL }, { 0xc3b8358109e84f07ULL, 0x0a862f80ec4700c8ULL },
+	{ 0xf4a642e14c6262c8ULL, 0xcd27bb612758c0faULL }, { 0x98e7e9cccfbd7dbdULL, 0x8038d51cb897789cULL },
+	{ 0xbf21e44003acdd2cULL, 0xe0470a63e6bd56c3ULL }, { 0xeeea5d5004981478ULL, 0x1858ccfce06cac74ULL },
+	{ 0x95527a5202df0ccbULL, 0x0f37801e0c43ebc8ULL }, { 0xbaa718e68396cffdULL, 0xd30560258f54e6baULL },
+	{ 0xe950df20247c83fdULL, 0x47c6b82ef32a2069ULL }, { 0x91d28b7416cdd27eULL, 0x4cdc331d57fa5441ULL },
+	{ 0xb6472e511c81471dULL, 0xe0133fe4adf8e952ULL }, { 0xe3d8f9e563a198e5ULL, 0x58180fddd97723a6ULL },
+	{ 0x8e679c2f5e44ff8fULL, 0x570f09eaa7ea7648ULL },
+};
 
-		if (*ctx->ptr != '\"' || !josh_iter_string(ctx)) {
-			JOSH_ERROR(ctx, JOSH_ERROR_EXPECTED_STRING);
+static inline uint64_t josh_mul64(uint64_t a, uint64_t b, uint64_t *high) {
+	// Multiply `a` by `b`, returning the low 64 bits of the product and storing
+	// the high 64 bits in `high`.
 
-			return false;
-		}
+#if defined(__SIZEOF_INT128__)
+	__extension__ typedef unsigned __int128 josh_uint128_t;
 
-		josh_iter_whitespace(ctx);
+	const josh_uint128_t product = (josh_uint128_t)a * b;
 
-		if (*ctx->ptr != ':') {
-			JOSH_ERROR(ctx, JOSH_ERROR_EXPECTED_COLON);
+	*high = (uint64_t)(product >> 64);
 
-			return false;
-		}
+	return (uint64_t)product;
+#else
+	const uint64_t a_lo = a & 0xffffffff;
+	const uint64_t a_hi = a >> 32;
+	const uint64_t b_lo = b & 0xffffffff;
+	const uint64_t b_hi = b >> 32;
 
-		josh_step_char(ctx);
-		josh_iter_whitespace(ctx);
+	const uint64_t lo_lo = a_lo * b_lo;
+	const uint64_t hi_lo = a_hi * b_lo;
+	const uint64_t lo_hi = a_lo * b_hi;
+	const uint64_t hi_hi = a_hi * b_hi;
 
-		const unsigned old_match_count = ctx->match_count;
+	const uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xffffffff) + lo_hi;
 
-		if (
-			ctx->current_level < ctx->key_count &&
-			ctx->keys[ctx->current_level].type == JOSH_KEY_TYPE_OBJECT &&
-			strncmp(
-				ctx->keys[ctx->current_level].str,
-				key,
-				ctx->keys[ctx->current_level].num
-			) == 0
-		) {
-			ctx->match_count++;
+	*high = hi_hi + (hi_lo >> 32) + (cross >> 32);
 
-			if (ctx->match_count == ctx->key_count) {
-				ctx->found_key = true;
-				ctx->value_pos = ctx->ptr;
-			}
-		}
+	return (cross << 32) | (lo_lo & 0xffffffff);
+#endif
+}
 
-		if (!josh_iter_value(ctx)) return false;
+static inline bool josh_eisel_lemire(uint64_t mantissa, int exponent, bool negative, double *out) {
+	// Convert `mantissa` * 10^`exponent` to the nearest double using the
+	// Eisel-Lemire algorithm. Return false if the result can't be decided
+	// with 128 bits of precision, or is subnormal or out of range, in which
+	// case the caller has to fall back to a slower conversion.
 
-		ctx->match_count = old_match_count;
+	uint64_t bits = 0;
 
-		if (ctx->found_key && ctx->current_level < ctx->key_count) break;
+	if (mantissa) {
+		if (exponent < JOSH_POW10_MIN_EXPONENT || exponent > JOSH_POW10_MAX_EXPONENT) return false;
 
-		if (*ctx->ptr == ',') {
-			josh_step_char(ctx);
-			const char c = josh_iter_whitespace(ctx);
+		const uint64_t *pow10 = josh_pow10_table[exponent - JOSH_POW10_MIN_EXPONENT];
 
-#if JOSH_CONFIG_ALLOW_TRAILING_COMMA == 0
-			if (c == '}') {
-				JOSH_ERROR(ctx, JOSH_ERROR_NO_TRAILING_COMMA);
+		const unsigned clz = 63 - josh_msb64(mantissa);
+		mantissa <<= clz;
 
-				return false;
-			}
-#endif
-		}
-	}
+		// floor(log2(10) * exponent) + 64 + bias - clz
+		int64_t exponent2 = ((217706 * (int64_t)exponent) >> 16) + 64 + 1023 - clz;
 
-	return true;
-}
+		uint64_t high;
+		uint64_t low = josh_mul64(mantissa, pow10[0], &high);
 
-static inline bool josh_is_key_terminator(char c) {
-	return c == '[' || c == '.';
-}
+		if ((high & 0x1ff) == 0x1ff && low + mantissa < mantissa) {
+			uint64_t carry_high;
+			const uint64_t carry_low = josh_mul64(mantissa, pow10[1], &carry_high);
 
-bool josh_parse_key(struct josh_ctx_t *ctx, const char *key) {
-	// Parse the JSON extraction schema (the key) into a codified format. Returns
-	// false if an error occurs.
+			const uint64_t merged_low = low + carry_high;
+			const uint64_t merged_high = high + (merged_low < low);
 
-	while (*key) {
-		if (ctx->key_count >= JOSH_CONFIG_MAX_DEPTH) {
-			JOSH_ERROR(ctx, JOSH_ERROR_KEY_MAX_DEPTH_REACHED);
+			if ((merged_high & 0x1ff) == 0x1ff && merged_low + 1 == 0 && carry_low + mantissa < mantissa) return false;
 
-			return false;
+			high = merged_high;
+			low = merged_low;
 		}
 
-		if (*key == '[') {
-			if (isdigit(key[1])) {
-				unsigned index = 0;
-				key++;
+		const unsigned msb = (unsigned)(high >> 63);
+		uint64_t result = high >> (msb + 9);
+		exponent2 -= 1 ^ msb;
 
-				for (;;) {
-					const char c = *key++;
+		// Exactly halfway between two doubles, which needs the full input to
+		// decide the rounding.
+		if (!low && !(high & 0x1ff) && (result & 3) == 1) return false;
 
-					if (c == ']') break;
+		result += result & 1;
+		result >>= 1;
 
-					if (!c) {
-						JOSH_ERROR(ctx, JOSH_ERROR_EXPECTED_KEY_CLOSING_BRACKET);
+		if (result >> 53) {
+			result >>= 1;
+			exponent2++;
+		}
 
-						return false;
-					}
+		if (exponent2 <= 0 || exponent2 >= 0x7ff) return false;
 
-					if (c < '0' || c > '9') {
-						JOSH_ERROR(ctx, JOSH_ERROR_KEY_NUMBER_INVALID);
+		bits = ((uint64_t)exponent2 << 52) | (result & 0x000fffffffffffff);
+	}
 
-						return false;
-					}
+	if (negative) bits |= 0x8000000000000000;
 
-					index = (index * 10) + ((unsigned)c - '0');
-				}
+	memcpy(out, &bits, sizeof(bits));
 
-				ctx->keys[ctx->key_count].num = index;
-				ctx->keys[ctx->key_count].type = JOSH_KEY_TYPE_ARRAY;
-				ctx->key_count++;
-			}
-			else if (key[1] == '\"') {
-				const char *string_end = strchr(key + 2, '\"');
+	return true;
+}
 
-				if (!string_end) {
-					JOSH_ERROR(ctx, JOSH_ERROR_EXPECTED_KEY_CLOSING_QUOTE);
+#if JOSH_USE_SWAR
+JOSH_NO_SANITIZE_ADDRESS
+static inline bool josh_parse_eight_digits(const char *ptr, uint64_t *out) {
+	// Convert the 8 chars at `ptr` to their value in `out` if they are all
+	// digits, without branching on each char. Return false otherwise, or if
+	// the read would cross into the next page.
 
-					return false;
-				}
+	if (((uintptr_t)ptr & 4095) > 4096 - 8) return false;
 
-				const unsigned len = (unsigned)(string_end - key - 2);
+	uint64_t chunk;
+	memcpy(&chunk, ptr, sizeof(chunk));
 
-				if (key[len + 3] != ']') {
-					JOSH_ERROR(ctx, JOSH_ERROR_EXPECTED_KEY_CLOSING_BRACKET);
+	if (((chunk & 0xf0f0f0f0f0f0f0f0) | (((chunk + 0x0606060606060606) & 0xf0f0f0f0f0f0f0f0) >> 4)) != 0x3333333333333333) {
+		return false;
+	}
 
-					return false;
-				}
+	chunk -= 0x3030303030303030;
+	chunk = (chunk * 10) + (chunk >> 8);
+	chunk = (((chunk & 0x000000ff000000ff) * 0x000f424000000064) + (((chunk >> 16) & 0x000000ff000000ff) * 0x0000271000000001)) >> 32;
 
-				char *new_key = josh_malloc(ctx, len + 1);
-				strncpy(new_key, key + 2, len);
-				new_key[len] = '\0';
+	*out = chunk & 0xffffffff;
 
-				ctx->keys[ctx->key_count].str = new_key;
-				ctx->keys[ctx->key_count].num = len;
-				ctx->keys[ctx->key_count].type = JOSH_KEY_TYPE_OBJECT;
-				ctx->key_count++;
+	return true;
+}
+#endif
 
-				key += len + 4;
-			}
-			else {
-				JOSH_ERROR(ctx, JOSH_ERROR_EXPECTED_KEY_VALUE);
+static inline double josh_decimal_to_double(
+	const char *str,
+	uint64_t mantissa,
+	int exponent,
+	bool negative,
+	bool truncated
+) {
+	// Convert the number `str`, already decomposed into `mantissa` *
+	// 10^`exponent`, to the nearest double. `truncated` is set if `mantissa`
+	// is missing some non-zero trailing digits of the number.
+
+	static const double exact_pow10[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+	};
+
+	double value;
+
+#if FLT_EVAL_METHOD == 0
+	// Both the mantissa and the power of ten are exact doubles, so a single
+	// correctly rounded operation gives the correctly rounded result.
+	if (!truncated && mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22) {
+		value = (double)mantissa;
+		value = exponent < 0 ? value / exact_pow10[-exponent] : value * exact_pow10[exponent];
+
+		return negative ? -value : value;
+	}
+#endif
 
-				return false;
-			}
+	if (josh_eisel_lemire(mantissa, exponent, negative, &value)) {
+		if (!truncated) return value;
+
+		// The real value lies between `mantissa` and `mantissa + 1`, so if both
+		// round to the same double, that double is the answer.
+		double upper;
+
+		if (
+			josh_eisel_lemire(mantissa + 1, exponent, negative, &upper) &&
+			!memcmp(&value, &upper, sizeof(value))
+		) {
+			return value;
 		}
-		else if (*key == '.') {
-			if (!key[1]) {
-				JOSH_ERROR(ctx, JOSH_ERROR_INVALID_KEY_OBJECT);
+	}
 
-				return false;
-			}
+	return strtod(str, NULL);
+}
 
-			const char *start = key + 1;
-			char c = 0;
+static inline void josh_resolve(struct josh_ctx_t *ctx, uint64_t found, const char *value) {
+	// Mark the keys in `found` as extracted, with the value spanning from
+	// `value` to the current position.
 
-			while ((c = *(++key))) {
-				if (
-					c == '_' ||
-					(c >= 'A' && c <= 'Z') ||
-					(c >= 'a' && c <= 'z') ||
-					(c >= '0' && c <= '9')
-				) {
-					continue;
-				}
+	for (uint64_t mask = found; mask; mask &= mask - 1) {
+		struct josh_result_t *result = &ctx->results[josh_ctz64(mask)];
 
-				if (josh_is_key_terminator(c)) break;
+		result->ptr = value;
+		result->len = (size_t)(ctx->ptr - value);
+		result->error_id = JOSH_ERROR_NONE;
+		result->offset = (size_t)(value - ctx->start);
 
-				JOSH_ERROR(ctx, JOSH_ERROR_INVALID_KEY_OBJECT);
+		if (ctx->callback) ctx->callback(ctx->user, josh_ctz64(mask), result);
+	}
 
-				return false;
-			}
+	// Keys with a wildcard can match again when there is a callback, so they
+	// stay pending until the end of the document.
+	ctx->pending &= ~(ctx->callback ? found & ~ctx->wildcards : found);
+	if (!ctx->pending) ctx->done = true;
+}
 
-			const unsigned len = (unsigned)(key - start);
+static inline void josh_fail(struct josh_ctx_t *ctx, uint64_t failed, enum josh_error error_id) {
+	// Mark the keys in `failed` as not extractable, for reason `error_id`.
 
-			char *new_key = josh_malloc(ctx, len + 1);
-			strncpy(new_key, start, len);
-			new_key[len] = '\0';
+	for (uint64_t mask = failed; mask; mask &= mask - 1) {
+		struct josh_result_t *result = &ctx->results[josh_ctz64(mask)];
 
-			ctx->keys[ctx->key_count].str = new_key;
-			ctx->keys[ctx->key_count].num = len;
-			ctx->keys[ctx->key_count].type = JOSH_KEY_TYPE_OBJECT;
-			ctx->key_count++;
-		}
-		else {
-			// should be impossible
+		result->ptr = NULL;
+		result->len = 0;
+		result->error_id = error_id;
+		result->offset = (size_t)(ctx->ptr - ctx->start);
 
-			return false;
-		}
+		if (ctx->callback) ctx->callback(ctx->user, josh_ctz64(mask), result);
 	}
 
-	return true;
+	ctx->pending &= ~failed;
+	if (failed && !ctx->pending) ctx->done = true;
 }
 
-bool josh_iter_string(struct josh_ctx_t *ctx) {
-	// Iterate the context until the end of the current string. Return true
-	// if the function succeeds.
+static inline bool josh_has_wildcard(const struct josh_path_t *path) {
+	for (unsigned i = 0; i < path->key_count; i++) {
+		if (path->keys[i].wildcard) return true;
+	}
 
-	char c = josh_step_char(ctx);
+	return false;
+}
 
-	while (c) {
-		if (c == '\\') {
-			c = josh_step_char(ctx);
+static inline bool josh_slice_from_end(const struct josh_path_t *path, unsigned level) {
+	// Return true if the key of `path` at `level` is a slice with a start or
+	// end counting from the end of the array.
 
-			if (
-				c == '\"' ||
-				c == '\\' ||
-				c == '/' ||
-				c == 'b' ||
-				c == 'f' ||
-				c == 'n' ||
-				c == 't' ||
-				c == 'r'
-			) {
-				c = josh_step_char(ctx);
+	const struct josh_key_t *key = &path->keys[level];
 
-				continue;
-			}
+	if (key->type != JOSH_KEY_TYPE_ARRAY || !key->wildcard) return false;
 
-			if (c == 'u') {
-				for (unsigned i = 0; i < 4; i++) {
-					c = josh_step_char(ctx);
+	return path->slices[level].start_from_end || path->slices[level].end_from_end;
+}
 
-					if (!isxdigit(c)) {
-						JOSH_ERROR(ctx, JOSH_ERROR_INVALID_UNICODE_ESCAPE_CODE);
+static inline bool josh_has_from_end(const struct josh_path_t *path) {
+	for (unsigned i = 0; i < path->key_count; i++) {
+		if (josh_slice_from_end(path, i)) return true;
+	}
 
-						return false;
-					}
-				}
+	return false;
+}
 
-				continue;
-			}
+static inline unsigned josh_slice_start(const struct josh_path_t *path, unsigned level, unsigned length) {
+	// Return where the array wildcard key of `path` at `level` starts in an
+	// array of `length` children.
 
-			JOSH_ERROR(ctx, JOSH_ERROR_INVALID_ESCAPE_CODE);
+	const unsigned start = path->keys[level].num;
 
-			return false;
-		}
+	if (!path->slices[level].start_from_end) return start;
 
-		if (c == '\"') {
-			josh_step_char(ctx);
-			break;
+	return start < length ? length - start : 0;
+}
+
+static inline unsigned josh_slice_end(const struct josh_path_t *path, unsigned level, unsigned length) {
+	// Return where the array wildcard key of `path` at `level` ends in an array
+	// of `length` children.
+
+	const unsigned end = path->slices[level].end;
+
+	if (!path->slices[level].end_from_end) return end;
+
+	return end < length ? length - end : 0;
+}
+
+static inline bool josh_in_slice(const struct josh_path_t *path, unsigned level, unsigned index, unsigned length) {
+	// Return true if `index` is in the array wildcard key of `path` at `level`,
+	// in an array of `length` children (only needed for slices counting from
+	// the end).
+
+	const unsigned start = josh_slice_start(path, level, length);
+	const unsigned step = path->slices[level].step;
+
+	return index >= start && index < josh_slice_end(path, level, length) && (step == 1 || (index - start) % step == 0);
+}
+
+static inline uint64_t josh_filter_finished(
+	const struct josh_path_t *paths,
+	uint64_t mask,
+	unsigned level,
+	bool closed,
+	unsigned index,
+	unsigned length
+) {
+	// Return the keys in `mask`, which are following a container at `level`,
+	// that can't match anything else once it is `closed`, or once its child at
+	// `index` is reached (out of `length`, for slices counting from the end).
+	// That is the case for keys without a wildcard before `level`, as then no
+	// other container can be followed by them, unless they are in a slice whose
+	// end hasn't been reached yet.
+
+	uint64_t out = 0;
+
+	for (uint64_t bits = mask; bits; bits &= bits - 1) {
+		const struct josh_path_t *path = &paths[josh_ctz64(bits)];
+		const struct josh_key_t *key = &path->keys[level];
+		bool finished = closed || (key->type == JOSH_KEY_TYPE_ARRAY && key->wildcard && index >= josh_slice_end(path, level, length));
+
+		for (unsigned i = 0; i < level && finished; i++) {
+			if (path->keys[i].wildcard) finished = false;
 		}
 
-		c = josh_step_char(ctx);
+		if (finished) out |= bits & -bits;
 	}
 
-	if (!c) {
-		JOSH_ERROR(ctx, JOSH_ERROR_STRING_NOT_CLOSED);
+	return out;
+}
+
+static inline enum josh_error josh_not_found_error(const struct josh_path_t *path) {
+	// Return the error for a key with a wildcard which matched nothing.
 
-		return false;
+	return path->keys[path->key_count - 1].type == JOSH_KEY_TYPE_OBJECT
+		? JOSH_ERROR_OBJECT_KEY_NOT_FOUND
+		: JOSH_ERROR_ARRAY_INDEX_NOT_FOUND;
+}
+
+static void josh_finish_wildcards(struct josh_ctx_t *ctx, uint64_t finished) {
+	// Stop looking for the keys with a wildcard in `finished`, which can't
+	// match anything else. Those which matched something (which have a length)
+	// are done, and the rest fail.
+
+	for (uint64_t mask = finished; mask; mask &= mask - 1) {
+		const unsigned i = josh_ctz64(mask);
+
+		if (ctx->results[i].len) ctx->pending &= ~(mask & -mask);
+		else josh_fail(ctx, mask & -mask, josh_not_found_error(&ctx->paths[i]));
 	}
 
-	return true;
+	if (finished && !ctx->pending) ctx->done = true;
 }
 
-bool josh_iter_number(struct josh_ctx_t *ctx) {
-	// Iterate the context until the end of the current number. Return true
-	// if the function succeeds.
+static inline uint64_t josh_filter_paths(
+	const struct josh_ctx_t *ctx,
+	uint64_t mask,
+	enum josh_key_type_t type
+) {
+	// Return the keys in `mask` whose key at the current level is of `type`.
 
-	const char *start = ctx->ptr;
+	uint64_t out = 0;
 
-	if (*ctx->ptr == '-') josh_step_char(ctx);
-	char c = *ctx->ptr;
-	const char *started_at = ctx->ptr;
+	for (; mask; mask &= mask - 1) {
+		const unsigned i = josh_ctz64(mask);
 
-	if (c == '0' && isdigit(ctx->ptr[1])) {
-		JOSH_ERROR(ctx, JOSH_ERROR_NO_LEADING_ZERO);
+		if (ctx->paths[i].keys[ctx->current_level].type == type) out |= mask & -mask;
+	}
+
+	return out;
+}
+
+static bool josh_scan_paths(
+	struct josh_ctx_t *ctx,
+	const char *json,
+	const struct josh_path_t *paths,
+	struct josh_result_t *results,
+	unsigned count
+) {
+	// Scan `json` once for the keys in `paths`. See josh_extract_paths().
+
+	ctx->ptr = ctx->start = json;
+	ctx->paths = paths;
+	ctx->results = results;
+	ctx->path_count = count;
+	ctx->done = false;
+
+	if (count > JOSH_MAX_PATHS) {
+		JOSH_ERROR(ctx, JOSH_ERROR_KEY_MAX_COUNT_REACHED);
 
 		return false;
 	}
 
-	while (c && isdigit(c)) c = josh_step_char(ctx);
-	if (ctx->ptr == started_at) goto fail;
+	uint64_t whole_value = 0;
+	ctx->pending = 0;
+	ctx->wildcards = 0;
+	ctx->from_end = 0;
 
-	bool is_floating_point = false;
+	for (unsigned i = 0; i < count; i++) {
+		ctx->pending |= (uint64_t)1 << i;
 
-	if (c == '.') {
-		is_floating_point = true;
+		if (!paths[i].key_count) whole_value |= (uint64_t)1 << i;
 
-		c = josh_step_char(ctx);
+		// The length is only set once a key with a wildcard matches.
+		if (josh_has_wildcard(&paths[i])) {
+			ctx->wildcards |= (uint64_t)1 << i;
+			results[i].len = 0;
+		}
 
-		started_at = ctx->ptr;
-		while (c && isdigit(c)) c = josh_step_char(ctx);
-		if (ctx->ptr == started_at) goto fail;
+		if (josh_has_from_end(&paths[i])) ctx->from_end |= (uint64_t)1 << i;
 	}
 
-	if (c == 'e' || c == 'E') {
-		is_floating_point = true;
+	if (!josh_peek_char(ctx, 0)) {
+		JOSH_ERROR(ctx, JOSH_ERROR_EMPTY_VALUE);
+		josh_fail(ctx, ctx->pending, ctx->error_id);
 
-		c = josh_step_char(ctx);
+		return false;
+	}
 
-		if (c == '-' || c == '+') c = josh_step_char(ctx);
+	const char c = josh_iter_whitespace(ctx);
 
-		started_at = ctx->ptr;
-		while (c && isdigit(c)) c = josh_step_char(ctx);
-		if (ctx->ptr == started_at) goto fail;
+	if (c != '[') {
+		josh_fail(ctx, josh_filter_paths(ctx, ctx->pending & ~whole_value, JOSH_KEY_TYPE_ARRAY), JOSH_ERROR_EXPECTED_ARRAY);
+	}
+	if (c != '{') {
+		josh_fail(ctx, josh_filter_paths(ctx, ctx->pending & ~whole_value, JOSH_KEY_TYPE_OBJECT), JOSH_ERROR_EXPECTED_OBJECT);
 	}
 
-	if (ctx->create_node) {
-		struct josh_node_t *node = josh_malloc(ctx, sizeof(struct josh_node_t));
+	if (!ctx->done) {
+		ctx->active = ctx->pending & ~whole_value;
+		ctx->open_targets = whole_value ? 1 : 0;
 
-		// TODO: throw error for huge values (potentially replace with inf/nan)
-		if (is_floating_point) {
-			node->type = JOSH_NODE_TYPE_FLOAT;
-			node->value._float = strtold(start, NULL);
+		if (!josh_iter_value(ctx)) {
+			josh_fail(ctx, ctx->pending, ctx->error_id);
 		}
-		else {
-			node->type = JOSH_NODE_TYPE_INT;
-			node->value._int = strtoll(start, NULL, 10);
+		else if (!ctx->done) {
+			const char *end = ctx->ptr;
+
+			if (josh_iter_whitespace(ctx)) {
+				JOSH_ERROR(ctx, JOSH_ERROR_UNEXPECTED_CHAR);
+				josh_fail(ctx, ctx->pending, ctx->error_id);
+			}
+			else {
+				ctx->ptr = end;
+				josh_resolve(ctx, whole_value, json);
+
+				josh_finish_wildcards(ctx, ctx->pending & ctx->wildcards);
+			}
 		}
 	}
 
-	if (!josh_is_value_terminator(*ctx->ptr)) goto fail;
+	for (unsigned i = 0; i < count; i++) {
+		if (results[i].error_id) return false;
+	}
 
 	return true;
+}
 
-fail:
-	JOSH_ERROR(ctx, JOSH_ERROR_DIGIT_EXPECTED);
+static void josh_record_shape(struct josh_shape_t *shape, const struct josh_result_t *results, uint64_t wildcards) {
+	// Remember which keys were found, so the next document can be predicted
+	// from where they were. Keys with a wildcard match more than one member,
+	// so they are always looked for.
 
-	return false;
+	shape->known = 0;
+
+	for (unsigned i = 0; i < shape->path_count; i++) {
+		if (!results[i].error_id && shape->paths[i].key_count) shape->known |= (uint64_t)1 << i;
+	}
+
+	shape->known &= ~wildcards;
 }
 
-bool josh_iter_literal(struct josh_ctx_t *ctx) {
-	// Iterate to the end of a JSON literal, such as null, true, or false. Return
-	// true if the function succeeds.
+bool josh_extract_paths(
+	struct josh_ctx_t *ctx,
+	const char *json,
+	const struct josh_path_t *paths,
+	struct josh_result_t *results,
+	unsigned count
+) {
+	// Extract all of the keys in `paths` from `json` in a single pass, storing
+	// the outcome of each key in the same index of `results`. Scanning stops as
+	// soon as every key has been found. Return true if all keys where found.
+	// The context is expected to have already been reset.
+
+	struct josh_shape_t *shape = ctx->shape;
+
+	if (!shape || ctx->callback || count > JOSH_MAX_PATHS) return josh_scan_paths(ctx, json, paths, results, count);
+
+	if (shape->paths != paths || shape->path_count != count) {
+		shape->paths = paths;
+		shape->path_count = count;
+		shape->known = 0;
+	}
 
-	const char c = *ctx->ptr;
+	if (shape->known) {
+		const char *end = ctx->end;
 
-	if (c == 't') {
-		if (strcmp(ctx->ptr, "true") < 0) {
-			JOSH_ERROR(ctx, JOSH_ERROR_EXPECTED_TRUE);
+		ctx->predicting = true;
+		const bool ok = josh_scan_paths(ctx, json, paths, results, count);
+		ctx->predicting = false;
 
-			return false;
-		}
+		if (!ctx->mispredicted) {
+			shape->hits++;
+			josh_record_shape(shape, results, ctx->wildcards);
 
-		if (ctx->create_node) {
-			struct josh_node_t *node = josh_malloc(ctx, sizeof(struct josh_node_t));
-			node->type = JOSH_NODE_TYPE_TRUE;
+			return ok;
 		}
 
-		josh_step_n_chars(ctx, 4);
+		// Scan again from the start, as keys were skipped on the way.
+		shape->misses++;
+		josh_reset(ctx);
+		ctx->end = end;
 	}
-	else if (c == 'f') {
-		if (strcmp(ctx->ptr, "false") < 0) {
-			JOSH_ERROR(ctx, JOSH_ERROR_EXPECTED_FALSE);
 
-			return false;
-		}
+	const bool ok = josh_scan_paths(ctx, json, paths, results, count);
+	josh_record_shape(shape, results, ctx->wildcards);
 
-		if (ctx->create_node) {
-			struct josh_node_t *node = josh_malloc(ctx, sizeof(struct josh_node_t));
-			node->type = JOSH_NODE_TYPE_FALSE;
-		}
+	return ok;
+}
 
-		josh_step_n_chars(ctx, 5);
+bool josh_extract_many_compiled(
+	struct josh_ctx_t *ctx,
+	const char *json,
+	const struct josh_path_t *paths,
+	struct josh_result_t *results,
+	unsigned count
+) {
+	// Extract `count` compiled keys from `json` in a single pass. See
+	// josh_extract_paths().
+
+	josh_reset(ctx);
+
+	return josh_extract_paths(ctx, json, paths, results, count);
+}
+
+bool josh_extract_many_compiled_n(
+	struct josh_ctx_t *ctx,
+	const char *json,
+	size_t len,
+	const struct josh_path_t *paths,
+	struct josh_result_t *results,
+	unsigned count
+) {
+	// Same as josh_extract_many_compiled(), except `json` is `len` chars long
+	// and does not need to be NUL terminated.
+
+	josh_reset(ctx);
+	ctx->end = json + len;
+
+	return josh_extract_paths(ctx, json, paths, results, count);
+}
+
+bool josh_extract_many(
+	struct josh_ctx_t *ctx,
+	const char *json,
+	const char *const *keys,
+	struct josh_result_t *results,
+	unsigned count
+) {
+	// Extract `count` keys from `json` in a single pass. See josh_extract_paths().
+	// The keys are compiled for every call, so prefer josh_extract_many_compiled()
+	// when using the same keys repeatedly. Up to JOSH_CONFIG_MANY_STACK_KEYS keys
+	// are compiled on the stack, and more are compiled into memory that is
+	// given back before returning.
+
+	josh_reset(ctx);
+
+	ctx->ptr = ctx->start = json;
+
+	if (count > JOSH_MAX_PATHS) {
+		JOSH_ERROR(ctx, JOSH_ERROR_KEY_MAX_COUNT_REACHED);
+
+		return false;
 	}
-	else if (c == 'n') {
-		if (strcmp(ctx->ptr, "null") < 0) {
-			JOSH_ERROR(ctx, JOSH_ERROR_EXPECTED_NULL);
 
-			return false;
-		}
+	struct josh_path_t stack_paths[JOSH_CONFIG_MANY_STACK_KEYS];
+	struct josh_path_t *paths = stack_paths;
+	const size_t bytes = count * sizeof(struct josh_path_t);
 
-		if (ctx->create_node) {
-			struct josh_node_t *node = josh_malloc(ctx, sizeof(struct josh_node_t));
-			node->type = JOSH_NODE_TYPE_NULL;
+	if (count > JOSH_CONFIG_MANY_STACK_KEYS) {
+		paths = ctx->arena
+			? josh_arena_alloc(ctx->arena, bytes, JOSH_ALIGNOF(struct josh_path_t))
+			: malloc(bytes);
+
+		if (!paths) {
+			JOSH_ERROR(ctx, JOSH_ERROR_OUT_OF_MEMORY);
 		}
+	}
 
-		josh_step_n_chars(ctx, 4);
+	bool compiled = paths != NULL;
+
+	for (unsigned i = 0; i < count && compiled; i++) {
+		compiled = josh_compile_key(ctx, &paths[i], keys[i]);
+	}
+
+	bool ok = false;
+
+	if (compiled) {
+		ok = josh_extract_paths(ctx, json, paths, results, count);
 	}
 	else {
-		JOSH_ERROR(ctx, JOSH_ERROR_EXPECTED_LITERAL);
+		for (unsigned i = 0; i < count; i++) {
+			results[i].ptr = NULL;
+			results[i].len = 0;
+			results[i].error_id = ctx->error_id;
+			results[i].offset = 0;
+		}
+	}
 
-		return false;
+	// Extracting doesn't allocate, so the paths are still the latest
+	// allocation in the arena, and can be given back.
+	if (paths && paths != stack_paths) {
+		if (ctx->arena) josh_arena_realloc(ctx->arena, paths, bytes, 0, JOSH_ALIGNOF(struct josh_path_t));
+		else free(paths);
 	}
 
-	return true;
+	return ok;
 }
 
-static inline char josh_iter_whitespace(struct josh_ctx_t *ctx) {
-	// Iterate context to next non whitespace character.
-
-	char c = *ctx->ptr;
+static inline const char *josh_extract_path(
+	struct josh_ctx_t *ctx,
+	const char *json,
+	const struct josh_path_t *path
+) {
+	struct josh_result_t result;
 
-	while (c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\f') {
-		if (c == '\n') {
-			ctx->line++;
-			ctx->column = 0;
-		}
+	if (!josh_extract_paths(ctx, json, path, &result, 1)) {
+		ctx->error_id = result.error_id;
+		ctx->offset = result.offset;
+		ctx->len = 0;
+		josh_error_position(ctx, &ctx->line, &ctx->column);
 
-		c = josh_step_char(ctx);
+		return NULL;
 	}
 
-	return c;
+	ctx->len = result.len;
+
+	return result.ptr;
 }
 
-static inline char josh_step_char(struct josh_ctx_t *ctx) {
-	return josh_step_n_chars(ctx, 1);
+const char *josh_extract_compiled(
+	struct josh_ctx_t *ctx,
+	const char *json,
+	const struct josh_path_t *path
+) {
+	// Same as josh_extract(), except using a key from josh_compile_key().
+
+	josh_reset(ctx);
+
+	return josh_extract_path(ctx, json, path);
 }
 
-static inline char josh_step_n_chars(struct josh_ctx_t *ctx, unsigned n) {
-	// Advance the context by n characters, returning the last character.
+static const char *josh_extract_key(struct josh_ctx_t *ctx, const char *json, const char *key) {
+	ctx->ptr = ctx->start = json;
 
-	ctx->ptr += n;
-	ctx->column += n;
-	if (ctx->found_key) ctx->len += n;
+	struct josh_path_t path;
+
+	if (!josh_compile_key(ctx, &path, key)) return NULL;
 
-	return *ctx->ptr;
+	memcpy(ctx->keys, path.keys, path.key_count * sizeof(struct josh_key_t));
+	ctx->key_count = path.key_count;
+
+	return josh_extract_path(ctx, json, &path);
 }
 
-void *josh_malloc(struct josh_ctx_t *ctx, size_t bytes) {
-	void *memory = ctx->memory + ctx->allocated;
+const char *josh_extract(struct josh_ctx_t *ctx, const char *json, const char *key) {
+	josh_reset(ctx);
 
-	ctx->allocated += bytes;
+	return josh_extract_key(ctx, json, key);
+}
 
-	if (ctx->allocated > JOSH_CONFIG_MAX_MEMORY) {
-		JOSH_ERROR(ctx, JOSH_ERROR_OUT_OF_MEMORY);
+const char *josh_extract_n(struct josh_ctx_t *ctx, const char *json, size_t len, const char *key) {
+	// Same as josh_extract(), except `json` is `len` chars long and does not
+	// need to be NUL terminated.
 
-		return NULL;
+	josh_reset(ctx);
+	ctx->end = json + len;
+
+	return josh_extract_key(ctx, json, key);
+}
+
+struct josh_extract_all_t {
+	struct josh_result_t *results;
+	size_t capacity;
+	size_t count;
+};
+
+static void josh_extract_all_callback(void *user, unsigned index, const struct josh_result_t *result) {
+	struct josh_extract_all_t *all = user;
+
+	(void)index;
+
+	if (result->error_id) return;
+	if (all->count < all->capacity) all->results[all->count] = *result;
+
+	all->count++;
+}
+
+size_t josh_extract_all(
+	struct josh_ctx_t *ctx,
+	const char *json,
+	const char *key,
+	struct josh_result_t *results,
+	size_t capacity
+) {
+	// Extract every value matching `key`, which can have wildcards in it, in a
+	// single pass. The first `capacity` values are stored in `results` in the
+	// order they appear, and the number of values (which can be more than
+	// `capacity`) is returned. Returns 0 and sets the error of the context if
+	// nothing matches or the JSON is invalid.
+
+	struct josh_extract_all_t all = { results, capacity, 0 };
+	void (*callback)(void *, unsigned, const struct josh_result_t *) = ctx->callback;
+	void *user = ctx->user;
+
+	ctx->callback = josh_extract_all_callback;
+	ctx->user = &all;
+
+	const char *out = josh_extract(ctx, json, key);
+
+	ctx->callback = callback;
+	ctx->user = user;
+
+	return out ? all.count : 0;
+}
+
+bool josh_cursor_enter(struct josh_ctx_t *ctx, struct josh_cursor_t *cursor, const char *value, size_t len) {
+	// Start a cursor over the elements of the array or object `value`, which
+	// is `len` chars long, such as one returned by josh_extract() (with the
+	// length in `ctx->len`). The cursor starts before the first element, so
+	// call josh_cursor_next() to get to it. Return false if `value` isn't an
+	// array or object, with JOSH_ERROR_EXPECTED_CONTAINER.
+
+	josh_reset(ctx);
+	ctx->ptr = ctx->start = value;
+	ctx->end = value + len;
+
+	const char c = josh_iter_whitespace(ctx);
+
+	if (c != '[' && c != '{') {
+		JOSH_ERROR(ctx, JOSH_ERROR_EXPECTED_CONTAINER);
+
+		return false;
 	}
 
-	return memory;
+	cursor->start = value;
+	cursor->ptr = ctx->ptr + 1;
+	cursor->end = value + len;
+	cursor->is_object = c == '{';
+	cursor->index = 0;
+	cursor->key = NULL;
+	cursor->key_len = 0;
+	cursor->value = NULL;
+	cursor->value_len = 0;
+
+	return true;
+}
+
+bool josh_cursor_next(struct josh_ctx_t *ctx, struct josh_cursor_t *cursor) {
+	// Move the cursor to the next element, scanning only that element (which
+	// is validated according to `ctx->validation`). Return false once there
+	// are no more, or if the JSON is invalid, in which case the error is set
+	// in the context.
+
+	josh_reset(ctx);
+	ctx->start = cursor->start;
+	ctx->ptr = cursor->ptr;
+	ctx->end = cursor->end;
+
+	const char close = cursor->is_object ? '}' : ']';
+	char c = josh_iter_whitespace(ctx);
+
+	if (c == close) {
+		cursor->ptr = ctx->ptr;
+
+		return false;
+	}
+
+	if (cursor->value) {
+		if (c != ',') {
+			JOSH_ERROR(ctx, JOSH_ERROR_UNEXPECTED_CHAR);
+
+			return false;
+		}
+
+		josh_step_char(ctx);
+		c = josh_iter_whitespace(ctx);
+
+		if (c == close) {
+#if JOSH_CONFIG_ALLOW_TRAILING_COMMA == 0
+			JOSH_ERROR(ctx, JOSH_ERROR_NO_TRAILING_COMMA);
+#else
+			cursor->ptr = ctx->ptr;
+#endif
+
+			return false;
+		}
+
+		cursor->index++;
+	}
+
+	if (cursor->is_object) {
+		const char *key = ctx->ptr + 1;
+
+		if (c != '\"' || !josh_iter_string(ctx)) {
+			JOSH_ERROR(ctx, JOSH_ERROR_EXPECTED_STRING);
+
+			return false;
+		}
+
+		cursor->key = key;
+		cursor->key_len = (size_t)(ctx->ptr - key - 1);
+
+		if (josh_iter_whitespace(ctx) != ':') {
+			JOSH_ERROR(ctx, JOSH_ERROR_EXPECTED_COLON);
+
+			return false;
+		}
+
+		josh_step_char(ctx);
+		josh_iter_whitespace(ctx);
+	}
+
+	const char *value = ctx->ptr;
+
+	if (!josh_peek_char(ctx, 0)) {
+		JOSH_ERROR(ctx, JOSH_ERROR_EMPTY_VALUE);
+
+		return false;
+	}
+
+	if (!josh_iter_value(ctx)) return false;
+
+	cursor->value = value;
+	cursor->value_len = (size_t)(ctx->ptr - value);
+	cursor->ptr = ctx->ptr;
+
+	return true;
+}
+
+const char *josh_cursor_key(const struct josh_cursor_t *cursor, size_t *len) {
+	// Return the key of the current element of an object (without the quotes),
+	// storing its length in `len`, or NULL for arrays.
+
+	*len = cursor->key_len;
+
+	return cursor->key;
+}
+
+const char *josh_cursor_value_span(const struct josh_cursor_t *cursor, size_t *len) {
+	// Return the current element, storing its length in `len`. This can be
+	// passed to josh_cursor_enter() to iterate a nested array or object.
+
+	*len = cursor->value_len;
+
+	return cursor->value;
+}
+
+static uint32_t josh_hash_json_key(const char *key, size_t len) {
+	// Hash the decoded name of the (already validated) object key `key`.
+
+	if (!memchr(key, '\\', len)) return josh_hash(key, len);
+
+	const char *end = key + len;
+	uint32_t hash = JOSH_HASH_BASIS;
+	char decoded[4];
+	unsigned decoded_len = 0;
+
+	while (key < end) {
+		key = josh_key_next(key, decoded, &decoded_len);
+		hash = josh_hash_extend(hash, decoded, decoded_len);
+	}
+
+	return hash;
+}
+
+static bool josh_json_key_equals(const struct josh_key_t *k, const char *key, size_t len) {
+	// Compare the name of the compiled object key `k` with the object key `key`
+	// of `len` chars, decoding its escapes if it has any.
+
+	if (!memchr(key, '\\', len)) return k->num == len && josh_key_equals(k, key);
+
+	const char *end = key + len;
+	char decoded[4];
+	unsigned decoded_len = 0;
+	unsigned i = 0;
+	struct josh_key_cursor_t cursor;
+
+	josh_key_cursor_init(&cursor, k);
+
+	while (key < end) {
+		key = josh_key_next(key, decoded, &decoded_len);
+
+		for (unsigned j = 0; j < decoded_len; j++, i++) {
+			if (i >= k->num) return false;
+
+			const char c = k->escaped ? josh_key_cursor_next(&cursor) : k->str[i];
+			if (c != decoded[j]) return false;
+		}
+	}
+
+	return i == k->num;
+}
+
+static int josh_compare_members(const void *a, const void *b) {
+	const struct josh_index_member_t *x = a;
+	const struct josh_index_member_t *y = b;
+
+	if (x->hash != y->hash) return x->hash < y->hash ? -1 : 1;
+
+	return x->entry < y->entry ? -1 : x->entry > y->entry;
+}
+
+static bool josh_index_value(struct josh_ctx_t *ctx, struct josh_index_t *index, const char *key, size_t key_len) {
+	// Add an entry for the value at the current position, whose key is `key`
+	// if it is in an object. Return true if the function succeeds.
+
+	if (index->count == index->capacity) {
+		JOSH_ERROR(ctx, JOSH_ERROR_OUT_OF_MEMORY);
+
+		return false;
+	}
+
+	struct josh_index_entry_t *entry = &index->entries[index->count++];
+
+	entry->start = (uint32_t)(ctx->ptr - ctx->start);
+	entry->len = 0;
+	entry->key = key ? (uint32_t)(key - ctx->start) : 0;
+	entry->key_len = (uint32_t)key_len;
+	entry->size = 1;
+	entry->count = 0;
+	entry->children = 0;
+
+	return true;
+}
+
+static bool josh_index_element(struct josh_ctx_t *ctx, struct josh_index_t *index, uint32_t parent) {
+	// Add the next child of the container entry `parent`, reading its key
+	// first if it is an object. Return true if the function succeeds.
+
+	const char *key = NULL;
+	size_t key_len = 0;
+
+	if (ctx->start[index->entries[parent].start] == '{') {
+		key = ctx->ptr + 1;
+
+		if (josh_peek_char(ctx, 0) != '\"' || !josh_iter_string(ctx)) {
+			JOSH_ERROR(ctx, JOSH_ERROR_EXPECTED_STRING);
+
+			return false;
+		}
+
+		key_len = (size_t)(ctx->ptr - key - 1);
+
+		if (josh_iter_whitespace(ctx) != ':') {
+			JOSH_ERROR(ctx, JOSH_ERROR_EXPECTED_COLON);
+
+			return false;
+		}
+
+		josh_step_char(ctx);
+		josh_iter_whitespace(ctx);
+	}
+
+	index->entries[parent].count++;
+
+	return josh_index_value(ctx, index, key, key_len);
+}
+
+static void josh_index_close(struct josh_ctx_t *ctx, struct josh_index_t *index, uint32_t container, uint32_t *members) {
+	// Finish the container entry `container`, whose closing bracket was just
+	// stepped past, by listing its children in the members of the index.
+
+	struct josh_index_entry_t *entry = &index->entries[container];
+	struct josh_index_member_t *children = &index->members[*members];
+	const bool is_object = ctx->start[entry->start] == '{';
+
+	entry->len = (uint32_t)(ctx->ptr - ctx->start) - entry->start;
+	entry->size = index->count - container;
+	entry->children = *members;
+
+	for (uint32_t i = 0, child = container + 1; i < entry->count; i++, child += index->entries[child].size) {
+		const struct josh_index_entry_t *value = &index->entries[child];
+
+		children[i].hash = is_object ? josh_hash_json_key(ctx->start + value->key, value->key_len) : 0;
+		children[i].entry = child;
+	}
+
+	if (is_object) qsort(children, entry->count, sizeof(*children), josh_compare_members);
+
+	*members += entry->count;
+}
+
+bool josh_index_build(struct josh_ctx_t *ctx, struct josh_index_t *index, const char *json, size_t len) {
+	// Index the document `json` of `len` chars in a single pass, recording the
+	// span of every value, and the children of every array and object. The
+	// whole document is validated. Return false if it is invalid, larger than
+	// 4GB, or has more values than the index has room for.
+
+	uint32_t open[JOSH_CONFIG_MAX_NESTING];
+	uint32_t depth = 0;
+	uint32_t members = 0;
+
+	josh_reset(ctx);
+	ctx->ptr = ctx->start = json;
+	ctx->end = json + len;
+	index->count = 0;
+
+	if (len > UINT32_MAX) {
+		JOSH_ERROR(ctx, JOSH_ERROR_DOCUMENT_TOO_LARGE);
+
+		return false;
+	}
+
+	if (!josh_iter_whitespace(ctx)) {
+		JOSH_ERROR(ctx, JOSH_ERROR_EMPTY_VALUE);
+
+		return false;
+	}
+
+	if (!josh_index_value(ctx, index, NULL, 0)) return false;
+
+	for (;;) {
+		struct josh_index_entry_t *entry = &index->entries[index->count - 1];
+		const char c = josh_peek_char(ctx, 0);
+
+		if (c == '[' || c == '{') {
+			if (depth == JOSH_CONFIG_MAX_NESTING) {
+				JOSH_ERROR(ctx, JOSH_ERROR_MAX_NESTING_REACHED);
+
+				return false;
+			}
+
+			open[depth++] = index->count - 1;
+
+			josh_step_char(ctx);
+
+			if (josh_iter_whitespace(ctx) != (c == '{' ? '}' : ']')) {
+				if (!josh_index_element(ctx, index, open[depth - 1])) return false;
+
+				continue;
+			}
+
+			josh_step_char(ctx);
+			josh_index_close(ctx, index, open[--depth], &members);
+		}
+		else {
+			if (c == '\"') {
+				if (!josh_iter_string(ctx)) return false;
+			}
+			else if (isdigit(c) || c == '-') {
+				if (!josh_iter_number(ctx)) return false;
+			}
+			else if (!josh_iter_literal(ctx)) {
+				return false;
+			}
+
+			entry->len = (uint32_t)(ctx->ptr - json) - entry->start;
+		}
+
+		// Close any containers which end after the value, then start the next
+		// child, like josh_iter_value().
+		for (;;) {
+			const char next = josh_iter_whitespace(ctx);
+
+			if (!depth) {
+				if (next) {
+					JOSH_ERROR(ctx, JOSH_ERROR_UNEXPECTED_CHAR);
+
+					return false;
+				}
+
+				return true;
+			}
+
+			const char close = json[index->entries[open[depth - 1]].start] == '{' ? '}' : ']';
+
+			if (next == close) {
+				josh_step_char(ctx);
+				josh_index_close(ctx, index, open[--depth], &members);
+
+				continue;
+			}
+
+			if (next != ',') {
+				JOSH_ERROR(ctx, JOSH_ERROR_UNEXPECTED_CHAR);
+
+				return false;
+			}
+
+			josh_step_char(ctx);
+
+			if (josh_iter_whitespace(ctx) == close) {
+#if JOSH_CONFIG_ALLOW_TRAILING_COMMA == 0
+				JOSH_ERROR(ctx, JOSH_ERROR_NO_TRAILING_COMMA);
+
+				return false;
+#else
+				josh_step_char(ctx);
+				josh_index_close(ctx, index, open[--depth], &members);
+
+				continue;
+#endif
+			}
+
+			if (!josh_index_element(ctx, index, open[depth - 1])) return false;
+
+			break;
+		}
+	}
+}
+
+static uint32_t josh_index_search(
+	struct josh_ctx_t *ctx,
+	const struct josh_index_t *index,
+	const char *json,
+	const struct josh_path_t *path,
+	unsigned level,
+	unsigned wildcard,
+	const struct josh_index_entry_t *container
+) {
+	// Return the entry of the value `path` leads to from `container`, which its
+	// key at `level` is looked up in, or 0 if there is none. `wildcard` is the
+	// level of the first wildcard in the key (or the key count if there isn't
+	// one). This follows the same rules as scanning: children which match but
+	// aren't the right type to carry on into are skipped, and the search ends
+	// in the first one which is, unless it is at or past the first wildcard.
+	// Object keys are found by binary searching the hashes of the keys of the
+	// object, which are in document order for equal hashes.
+
+	const struct josh_key_t *key = &path->keys[level];
+	const struct josh_index_member_t *children = &index->members[container->children];
+	const bool is_object = key->type == JOSH_KEY_TYPE_OBJECT;
+	uint32_t first = 0;
+	uint32_t last = container->count;
+	uint32_t step = 1;
+	uint32_t next_child = (uint32_t)(container - index->entries) + 1;
+
+	if (!is_object) {
+		const uint32_t end = key->wildcard ? josh_slice_end(path, level, container->count) : key->num + 1;
+
+		first = key->wildcard ? josh_slice_start(path, level, container->count) : key->num;
+		if (end < last) last = end;
+		if (key->wildcard) step = path->slices[level].step;
+	}
+	else if (!key->wildcard) {
+		uint32_t high = container->count;
+
+		while (first < high) {
+			const uint32_t middle = first + (high - first) / 2;
+
+			if (children[middle].hash < key->hash) first = middle + 1;
+			else high = middle;
+		}
+	}
+
+	for (uint32_t i = first; i < last; i += step) {
+		uint32_t child;
+
+		if (!is_object) {
+			child = children[i].entry;
+		}
+		else if (key->wildcard) {
+			// Members are in hash order, so a wildcard walks the entries instead.
+			child = next_child;
+			next_child += index->entries[child].size;
+		}
+		else {
+			if (children[i].hash != key->hash) break;
+
+			child = children[i].entry;
+
+			const struct josh_index_entry_t *member = &index->entries[child];
+
+			if (!josh_json_key_equals(key, json + member->key, member->key_len)) continue;
+		}
+
+		if (level + 1 == path->key_count) return child;
+
+		const struct josh_index_entry_t *value = &index->entries[child];
+
+		if (json[value->start] != (path->keys[level + 1].type == JOSH_KEY_TYPE_OBJECT ? '{' : '[')) continue;
+
+		const uint32_t found = josh_index_search(ctx, index, json, path, level + 1, wildcard, value);
+
+		if (found || level < wildcard) return found;
+	}
+
+	if (level > wildcard) return 0;
+
+	// Scanning gives up at the end of the container, or if the first wildcard
+	// is a slice, at the comma after the child before its end (which is only
+	// checked from the comma after the first child on).
+	const uint32_t slice_end = is_object ? 0 : josh_slice_end(path, level, container->count);
+	const uint32_t stop = slice_end ? slice_end : 1;
+
+	if (level == wildcard && !is_object && stop < container->count) {
+		const struct josh_index_entry_t *end = &index->entries[children[stop - 1].entry];
+
+		ctx->ptr = json + end->start + end->len;
+
+		while (*ctx->ptr != ',') ctx->ptr++;
+	}
+	else {
+		ctx->ptr = json + container->start + container->len - 1;
+	}
+
+	if (wildcard < path->key_count) {
+		JOSH_ERROR(ctx, josh_not_found_error(path));
+	}
+	else {
+		JOSH_ERROR(ctx, is_object ? JOSH_ERROR_OBJECT_KEY_NOT_FOUND : JOSH_ERROR_ARRAY_INDEX_NOT_FOUND);
+	}
+
+	return 0;
+}
+
+const char *josh_extract_indexed_compiled(
+	struct josh_ctx_t *ctx,
+	const struct josh_index_t *index,
+	const char *json,
+	const struct josh_path_t *path
+) {
+	// Same as josh_extract_compiled(), except the value is looked up in
+	// `index`, an index of `json` made by josh_index_build(), rather than by
+	// scanning `json`. The same value (or error) is found either way.
+
+	josh_reset(ctx);
+	ctx->ptr = ctx->start = json;
+
+	const struct josh_index_entry_t *root = index->entries;
+
+	// The whole document includes any whitespace before the value.
+	if (!path->key_count) {
+		ctx->len = root->start + root->len;
+
+		return json;
+	}
+
+	const bool is_object = path->keys[0].type == JOSH_KEY_TYPE_OBJECT;
+
+	ctx->ptr = json + root->start;
+
+	if (*ctx->ptr != (is_object ? '{' : '[')) {
+		JOSH_ERROR(ctx, is_object ? JOSH_ERROR_EXPECTED_OBJECT : JOSH_ERROR_EXPECTED_ARRAY);
+
+		return NULL;
+	}
+
+	unsigned wildcard = 0;
+
+	while (wildcard < path->key_count && !path->keys[wildcard].wildcard) wildcard++;
+
+	const uint32_t found = josh_index_search(ctx, index, json, path, 0, wildcard, root);
+
+	if (!found) return NULL;
+
+	ctx->len = index->entries[found].len;
+
+	return json + index->entries[found].start;
+}
+
+const char *josh_extract_indexed(
+	struct josh_ctx_t *ctx,
+	const struct josh_index_t *index,
+	const char *json,
+	const char *key
+) {
+	// Same as josh_extract(), except the value is looked up in `index`. See
+	// josh_extract_indexed_compiled().
+
+	struct josh_path_t path;
+
+	josh_reset(ctx);
+
+	if (!josh_compile_key(ctx, &path, key)) return NULL;
+
+	return josh_extract_indexed_compiled(ctx, index, json, &path);
+}
+
+bool josh_file_read(struct josh_ctx_t *ctx, struct josh_file_t *file, FILE *stream) {
+	// Read the rest of `stream` into `file`, for input which can't be mapped
+	// (such as pipes). Return true if the function succeeds.
+
+	size_t capacity = JOSH_CONFIG_ARENA_BLOCK_SIZE;
+	char *data = NULL;
+
+	file->data = NULL;
+	file->len = 0;
+	file->mapped = false;
+
+	for (;;) {
+		char *grown = realloc(data, capacity);
+
+		if (!grown) {
+			free(data);
+			JOSH_ERROR(ctx, JOSH_ERROR_OUT_OF_MEMORY);
+
+			return false;
+		}
+
+		data = grown;
+		file->len += fread(data + file->len, 1, capacity - file->len, stream);
+
+		if (file->len < capacity) break;
+
+		capacity *= 2;
+	}
+
+	if (ferror(stream)) {
+		free(data);
+		file->len = 0;
+		JOSH_ERROR(ctx, JOSH_ERROR_FILE_NOT_READABLE);
+
+		return false;
+	}
+
+	file->data = data;
+
+	return true;
+}
+
+bool josh_file_open(struct josh_ctx_t *ctx, struct josh_file_t *file, const char *path) {
+	// Open the file at `path` for reading into `file`. Regular files are mapped
+	// into memory when possible, so they are only read as they are scanned.
+	// Return true if the function succeeds.
+
+	file->data = NULL;
+	file->len = 0;
+	file->mapped = false;
+
+#if JOSH_CONFIG_USE_MMAP
+	const int fd = open(path, O_RDONLY);
+
+	if (fd < 0) {
+		JOSH_ERROR(ctx, JOSH_ERROR_FILE_NOT_READABLE);
+
+		return false;
+	}
+
+	struct stat info;
+
+	if (!fstat(fd, &info) && S_ISREG(info.st_mode) && info.st_size > 0) {
+		const size_t len = (size_t)info.st_size;
+		void *data = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+
+		close(fd);
+
+		if (data == MAP_FAILED) {
+			JOSH_ERROR(ctx, JOSH_ERROR_FILE_NOT_READABLE);
+
+			return false;
+		}
+
+		// JSON is scanned front to back, so the kernel can read ahead further.
+		posix_madvise(data, len, POSIX_MADV_SEQUENTIAL);
+
+		file->data = data;
+		file->len = len;
+		file->mapped = true;
+
+		return true;
+	}
+
+	FILE *stream = fdopen(fd, "rb");
+
+	if (!stream) close(fd);
+#else
+	FILE *stream = fopen(path, "rb");
+#endif
+
+	if (!stream) {
+		JOSH_ERROR(ctx, JOSH_ERROR_FILE_NOT_READABLE);
+
+		return false;
+	}
+
+	const bool ok = josh_file_read(ctx, file, stream);
+	fclose(stream);
+
+	return ok;
+}
+
+void josh_file_close(struct josh_file_t *file) {
+	void *data = (void *)(uintptr_t)file->data;
+
+#if JOSH_CONFIG_USE_MMAP
+	if (file->mapped) munmap(data, file->len);
+	else free(data);
+#else
+	free(data);
+#endif
+
+	file->data = NULL;
+	file->len = 0;
+	file->mapped = false;
+}
+
+const char *josh_extract_file(struct josh_ctx_t *ctx, struct josh_file_t *file, const char *path, const char *key) {
+	// Open the file at `path` into `file` and extract `key` from it. The value
+	// points into `file`, which has to be closed with josh_file_close() even if
+	// the extraction fails.
+
+	josh_reset(ctx);
+
+	if (!josh_file_open(ctx, file, path)) return NULL;
+
+	return josh_extract_n(ctx, file->data, file->len, key);
+}
+
+struct josh_node_t *josh_parse_file(struct josh_ctx_t *ctx, struct josh_file_t *file, const char *path) {
+	// Open the file at `path` into `file` and parse it. String nodes point into
+	// `file`, which has to be closed with josh_file_close() even if parsing
+	// fails.
+
+	josh_reset(ctx);
+
+	if (!josh_file_open(ctx, file, path)) return NULL;
+
+	return josh_parse_n(ctx, file->data, file->len);
+}
+
+static bool josh_ndjson_split(struct josh_ndjson_t *out, const char *data, size_t len) {
+	// Find where each record in `data` starts and ends. Raw newlines can't
+	// appear inside JSON values, so each one ends a record, and memchr() can
+	// look for them a whole vector at a time. Lines with nothing but
+	// whitespace (such as the "\r" left of a blank line ending in CRLF) are
+	// skipped.
+
+	size_t capacity = 0;
+	const char *ptr = data;
+	const char *end = data + len;
+
+	while (ptr < end) {
+		const char *newline = memchr(ptr, '\n', (size_t)(end - ptr));
+		if (!newline) newline = end;
+
+		const char *first = ptr;
+
+		while (first < newline && josh_is_whitespace(*first)) first++;
+
+		if (first < newline) {
+			if (out->record_count == capacity) {
+				capacity = capacity ? capacity * 2 : 1024;
+
+				size_t *record_offsets = realloc(out->record_offsets, capacity * sizeof(size_t));
+				if (record_offsets) out->record_offsets = record_offsets;
+
+				size_t *record_lens = realloc(out->record_lens, capacity * sizeof(size_t));
+				if (record_lens) out->record_lens = record_lens;
+
+				if (!record_offsets || !record_lens) return false;
+			}
+
+			out->record_offsets[out->record_count] = (size_t)(ptr - data);
+			out->record_lens[out->record_count] = (size_t)(newline - ptr);
+			out->record_count++;
+		}
+
+		ptr = newline + 1;
+	}
+
+	return true;
+}
+
+static void josh_ndjson_extract_records(
+	struct josh_ndjson_t *out,
+	const char *data,
+	const struct josh_path_t *paths,
+	unsigned count,
+	size_t from,
+	size_t to,
+	struct josh_shape_t *shape
+) {
+	// Extract `paths` from records `from` up to `to`, with a context of its own
+	// so that batches can run on different threads. Each thread keeps its own
+	// `shape` across batches if shape hints are on, or it is NULL.
+
+	struct josh_ctx_t ctx = { 0 };
+	struct josh_result_t results[JOSH_MAX_PATHS];
+
+	ctx.shape = shape;
+
+	for (size_t r = from; r < to; r++) {
+		const size_t record_offset = out->record_offsets[r];
+		const char *record = data + record_offset;
+
+		josh_extract_many_compiled_n(&ctx, record, out->record_lens[r], paths, results, count);
+
+		for (unsigned p = 0; p < count; p++) {
+			const size_t i = p * out->record_count + r;
+
+			out->offsets[i] = record_offset + (results[p].ptr ? (size_t)(results[p].ptr - record) : results[p].offset);
+			out->lens[i] = results[p].len;
+			out->error_ids[i] = results[p].error_id;
+		}
+	}
+}
+
+#if JOSH_CONFIG_USE_THREADS
+struct josh_ndjson_work_t {
+	struct josh_ndjson_t *out;
+	const char *data;
+	const struct josh_path_t *paths;
+	unsigned count;
+	bool shape_hints;
+
+	pthread_mutex_t lock;
+	size_t next;
+};
+
+static void *josh_ndjson_worker(void *arg) {
+	// Keep taking batches of records until there are none left.
+
+	struct josh_ndjson_work_t *work = arg;
+	struct josh_shape_t shape = { 0 };
+
+	for (;;) {
+		pthread_mutex_lock(&work->lock);
+		const size_t from = work->next;
+		size_t to = from + JOSH_CONFIG_NDJSON_BATCH_SIZE;
+		if (to > work->out->record_count) to = work->out->record_count;
+		work->next = to;
+
+		if (from == to) {
+			work->out->shape_hits += shape.hits;
+			work->out->shape_misses += shape.misses;
+			pthread_mutex_unlock(&work->lock);
+
+			return NULL;
+		}
+
+		pthread_mutex_unlock(&work->lock);
+
+		josh_ndjson_extract_records(
+			work->out, work->data, work->paths, work->count, from, to, work->shape_hints ? &shape : NULL
+		);
+	}
+}
+#endif
+
+void josh_ndjson_free(struct josh_ndjson_t *out) {
+	free(out->record_offsets);
+	free(out->record_lens);
+	free(out->offsets);
+	free(out->lens);
+	free(out->error_ids);
+
+	out->record_count = 0;
+	out->record_offsets = out->record_lens = out->offsets = out->lens = NULL;
+	out->error_ids = NULL;
+}
+
+bool josh_ndjson_extract(
+	struct josh_ndjson_t *out,
+	const char *data,
+	size_t len,
+	const struct josh_path_t *paths,
+	unsigned count,
+	unsigned threads,
+	bool shape_hints
+) {
+	// Extract `count` compiled keys from every record of the newline delimited
+	// JSON in `data`, using up to `threads` threads (or one per CPU if 0). With
+	// `shape_hints`, where keys are in each record is predicted from the
+	// records before it (see josh_shape_t), for records which all have their
+	// keys in the same order. The results must be freed with josh_ndjson_free()
+	// even if this fails. Return true if the function succeeds, even if some
+	// keys weren't found.
+
+	out->record_count = 0;
+	out->record_offsets = out->record_lens = out->offsets = out->lens = NULL;
+	out->error_ids = NULL;
+	out->error_id = JOSH_ERROR_NONE;
+	out->shape_hits = out->shape_misses = 0;
+
+	if (count > JOSH_MAX_PATHS) {
+		out->error_id = JOSH_ERROR_KEY_MAX_COUNT_REACHED;
+
+		return false;
+	}
+
+	if (!josh_ndjson_split(out, data, len)) {
+		out->error_id = JOSH_ERROR_OUT_OF_MEMORY;
+
+		return false;
+	}
+
+	const size_t values = out->record_count * count;
+
+	if (!values) return true;
+
+	out->offsets = malloc(values * sizeof(size_t));
+	out->lens = malloc(values * sizeof(size_t));
+	out->error_ids = malloc(values * sizeof(enum josh_error));
+
+	if (!out->offsets || !out->lens || !out->error_ids) {
+		out->error_id = JOSH_ERROR_OUT_OF_MEMORY;
+
+		return false;
+	}
+
+#if JOSH_CONFIG_USE_THREADS
+	if (!threads) {
+		const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		threads = cpus > 0 ? (unsigned)cpus : 1;
+	}
+
+	const size_t batches = (out->record_count + JOSH_CONFIG_NDJSON_BATCH_SIZE - 1) / JOSH_CONFIG_NDJSON_BATCH_SIZE;
+	if (threads > batches) threads = (unsigned)batches;
+
+	if (threads > 1) {
+		struct josh_ndjson_work_t work = { out, data, paths, count, shape_hints, PTHREAD_MUTEX_INITIALIZER, 0 };
+		pthread_t *workers = malloc((threads - 1) * sizeof(pthread_t));
+		unsigned started = 0;
+
+		// The calling thread is a worker too, so it finishes the job on its own
+		// if no more threads can be started.
+		while (workers && started < threads - 1) {
+			if (pthread_create(&workers[started], NULL, josh_ndjson_worker, &work)) break;
+
+			started++;
+		}
+
+		josh_ndjson_worker(&work);
+
+		for (unsigned i = 0; i < started; i++) {
+			pthread_join(workers[i], NULL);
+		}
+
+		free(workers);
+		pthread_mutex_destroy(&work.lock);
+
+		return true;
+	}
+#else
+	(void)threads;
+#endif
+
+	struct josh_shape_t shape = { 0 };
+
+	josh_ndjson_extract_records(out, data, paths, count, 0, out->record_count, shape_hints ? &shape : NULL);
+	out->shape_hits = shape.hits;
+	out->shape_misses = shape.misses;
+
+	return true;
+}
+
+static inline bool josh_is_object_level(const struct josh_ctx_t *ctx, unsigned level) {
+	return (ctx->objects[level / 64] >> (level % 64)) & 1;
+}
+
+static inline uint64_t josh_match_key(
+	const struct josh_ctx_t *ctx,
+	const struct josh_frame_t *frame,
+	uint64_t candidates,
+	bool is_object,
+	const char *key,
+	unsigned key_len
+) {
+	// Return the keys in `candidates` which match the current child of `frame`,
+	// which is at `key` in an object, or at `frame->index` in an array. Object
+	// keys are compared by length first, so most are ruled out without reading
+	// them.
+
+	uint64_t matched = 0;
+	uint32_t hash = 0;
+	bool hashed = false;
+	bool compared = false;
+
+	for (uint64_t mask = candidates; mask; mask &= mask - 1) {
+		const struct josh_key_t *k = &ctx->paths[josh_ctz64(mask)].keys[ctx->current_level];
+
+		if (!is_object) {
+			if (k->type != JOSH_KEY_TYPE_ARRAY) continue;
+
+			if (k->wildcard ? josh_in_slice(&ctx->paths[josh_ctz64(mask)], ctx->current_level, frame->index, frame->hint) : k->num == frame->index) {
+				matched |= mask & -mask;
+			}
+
+			continue;
+		}
+
+		if (k->type != JOSH_KEY_TYPE_OBJECT) continue;
+
+		if (k->wildcard) {
+			matched |= mask & -mask;
+
+			continue;
+		}
+
+		if (k->num != key_len) continue;
+
+		// The first candidate is compared directly, which stops at the first
+		// word that differs. If there are more, hashing the key once lets most
+		// of them be ruled out without comparing.
+		if (compared) {
+			if (!hashed) {
+				hash = josh_hash(key, key_len);
+				hashed = true;
+			}
+
+			if (k->hash != hash) continue;
+		}
+
+		compared = true;
+
+		if (josh_key_equals(k, key)) matched |= mask & -mask;
+	}
+
+	return matched;
+}
+
+static uint64_t josh_match_escaped_key(
+	const struct josh_ctx_t *ctx,
+	uint64_t candidates,
+	const char *key,
+	unsigned key_len
+) {
+	// Return the object keys in `candidates` which match the escaped object key
+	// `key`, decoding it as it is compared with each of them, for keys too long
+	// to decode into a buffer on the stack. An escape is at most 6 chars for
+	// each decoded byte, so keys whose length is out of that range are ruled
+	// out without decoding them.
+
+	uint64_t matched = 0;
+
+	for (uint64_t mask = candidates; mask; mask &= mask - 1) {
+		const struct josh_key_t *k = &ctx->paths[josh_ctz64(mask)].keys[ctx->current_level];
+
+		if (k->type != JOSH_KEY_TYPE_OBJECT) continue;
+
+		if (k->wildcard) {
+			matched |= mask & -mask;
+
+			continue;
+		}
+
+		if (k->num > key_len || (key_len + 5) / 6 > k->num) continue;
+
+		if (josh_json_key_equals(k, key, key_len)) matched |= mask & -mask;
+	}
+
+	return matched;
+}
+
+static inline uint64_t josh_predict_keys(const struct josh_ctx_t *ctx, struct josh_frame_t *frame, uint64_t predicted) {
+	// Return the keys in `predicted` which matched the child of `frame` at
+	// its current index in the last document, and set `frame->hint` to the
+	// next child the others did, so the children before it can be skipped.
+
+	const unsigned level = ctx->depth - 1;
+	uint64_t expected = 0;
+	unsigned next = UINT_MAX;
+
+	for (uint64_t mask = predicted; mask; mask &= mask - 1) {
+		const unsigned ordinal = ctx->shape->ordinals[josh_ctz64(mask)][level];
+
+		if (ordinal == frame->index) expected |= mask & -mask;
+		else if (ordinal > frame->index && ordinal < next) next = ordinal;
+	}
+
+	frame->hint = next;
+
+	return expected;
+}
+
+static inline bool josh_begin_element(struct josh_ctx_t *ctx) {
+	// Start the next child of the innermost container, reading its key first
+	// if it is an object. Return true if the function succeeds.
+
+	const unsigned level = ctx->depth - 1;
+	const bool is_object = josh_is_object_level(ctx, level);
+	const char *key = NULL;
+	unsigned key_len = 0;
+
+	if (is_object) {
+		key = ctx->ptr + 1;
+
+		if (josh_peek_char(ctx, 0) != '\"' || !josh_iter_string(ctx)) {
+			JOSH_ERROR(ctx, JOSH_ERROR_EXPECTED_STRING);
+
+			return false;
+		}
+
+		key_len = (unsigned)(ctx->ptr - key - 1);
+
+		if (ctx->create_node && !josh_alloc_string_node(ctx, JOSH_NODE_TYPE_KEY, key - 1)) return false;
+
+		if (josh_iter_whitespace(ctx) != ':') {
+			JOSH_ERROR(ctx, JOSH_ERROR_EXPECTED_COLON);
+
+			return false;
+		}
+
+		josh_step_char(ctx);
+		josh_iter_whitespace(ctx);
+	}
+
+	if (level >= JOSH_CONFIG_MAX_DEPTH) {
+		ctx->active = 0;
+		ctx->current_level++;
+
+		return true;
+	}
+
+	struct josh_frame_t *frame = &ctx->frames[level];
+	uint64_t candidates = frame->active & ctx->pending;
+	uint64_t expected = 0;
+	uint64_t matched = 0;
+	uint64_t found = 0;
+
+	// Keys whose place in this object is known are only compared with the
+	// member they were at in the last document, which has to match.
+	if (ctx->predicting && is_object && candidates) {
+		const uint64_t predicted = candidates & ctx->shape->known;
+
+		if (predicted && frame->index >= frame->hint) expected = josh_predict_keys(ctx, frame, predicted);
+
+		candidates = (candidates & ~predicted) | expected;
+	}
+
+	if (candidates && is_object && ctx->has_escapes) {
+		// Compiled keys are unescaped, so escaped object keys are decoded
+		// before being compared. Decoding never makes a key longer. Keys that
+		// don't fit the buffer are decoded while comparing them instead.
+		char decoded[128];
+
+		if (key_len <= sizeof(decoded)) {
+			matched = josh_match_key(ctx, frame, candidates, true, decoded, (unsigned)josh_unescape(decoded, key, key_len));
+		}
+		else {
+			matched = josh_match_escaped_key(ctx, candidates, key, key_len);
+		}
+	}
+	else if (candidates) {
+		matched = josh_match_key(ctx, frame, candidates, is_object, key, key_len);
+	}
+
+	if (expected & ~matched) {
+		ctx->mispredicted = true;
+
+		return false;
+	}
+
+	if (ctx->shape && is_object) {
+		for (uint64_t mask = matched; mask; mask &= mask - 1) {
+			ctx->shape->ordinals[josh_ctz64(mask)][level] = frame->index;
+		}
+	}
+
+	for (uint64_t mask = matched; mask; mask &= mask - 1) {
+		const unsigned i = josh_ctz64(mask);
+
+		if (ctx->paths[i].key_count == level + 1) found |= mask & -mask;
+	}
+
+	// The start of the value is kept in the result of the first key it is for,
+	// until the value ends and the keys are resolved.
+	if (found) {
+		ctx->results[josh_ctz64(found)].ptr = ctx->ptr;
+		ctx->open_targets++;
+	}
+
+	frame->found = found;
+	ctx->active = matched & ~found;
+	ctx->current_level++;
+
+	return true;
+}
+
+static inline bool josh_close_container(struct josh_ctx_t *ctx) {
+	// Close the innermost container, failing the keys which were looking for a
+	// child it doesn't have, then step past its closing bracket. Return false
+	// if that means all keys are done, so scanning can stop.
+
+	const unsigned level = ctx->depth - 1;
+
+	if (ctx->create_node) {
+		// While open, the size of a container node holds its parent's index.
+		const struct josh_node_t *node = &ctx->root[ctx->open_node];
+		const unsigned parent = node->value._container.size;
+
+		josh_close_container_node(ctx, ctx->open_node, node->value._container.count);
+		ctx->open_node = parent;
+	}
+
+	if (level < JOSH_CONFIG_MAX_DEPTH && ctx->frames[level].active) {
+		const bool is_object = josh_is_object_level(ctx, level);
+		const enum josh_key_type_t type = is_object ? JOSH_KEY_TYPE_OBJECT : JOSH_KEY_TYPE_ARRAY;
+
+		// Like other keys, those with a wildcard are only done with a container
+		// of the type they were looking for.
+		josh_finish_wildcards(ctx, josh_filter_finished(
+			ctx->paths,
+			josh_filter_paths(ctx, ctx->frames[level].active & ctx->pending & ctx->wildcards, type),
+			level,
+			true,
+			0,
+			0
+		));
+
+		// Keys with a wildcard can still match in a later sibling, so they are
+		// only failed at the end of the document.
+		const uint64_t missing = josh_filter_paths(
+			ctx,
+			ctx->frames[level].active & ctx->pending & ~ctx->wildcards,
+			type
+		);
+
+		// A predicted key may have been skipped over rather than be missing.
+		if (ctx->predicting && is_object && (missing & ctx->shape->known)) {
+			ctx->mispredicted = true;
+			ctx->done = true;
+
+			return false;
+		}
+
+		josh_fail(ctx, missing, is_object ? JOSH_ERROR_OBJECT_KEY_NOT_FOUND : JOSH_ERROR_ARRAY_INDEX_NOT_FOUND);
+
+		if (ctx->done) return false;
+	}
+
+	josh_step_char(ctx);
+	ctx->depth--;
+
+	return true;
+}
+
+static unsigned josh_count_children(struct josh_ctx_t *ctx) {
+	// Return how many children the array at the current position (just after
+	// its opening bracket) has, without moving the context. Invalid input is
+	// counted up to where it goes wrong, and left for the scan to report.
+
+	const char *ptr = ctx->ptr;
+	const unsigned line = ctx->line;
+	const unsigned column = ctx->column;
+	const enum josh_error error_id = ctx->error_id;
+	const size_t offset = ctx->offset;
+	const size_t len = ctx->len;
+	unsigned count = 0;
+
+	// A trailing comma (see JOSH_CONFIG_ALLOW_TRAILING_COMMA) isn't a child.
+	for (char c = josh_peek_char(ctx, 0); c != ']';) {
+		count++;
+
+		if (!josh_skip_value(ctx) || josh_iter_whitespace(ctx) != ',') break;
+
+		josh_step_char(ctx);
+		c = josh_iter_whitespace(ctx);
+	}
+
+	ctx->ptr = ptr;
+	ctx->line = line;
+	ctx->column = column;
+	ctx->error_id = error_id;
+	ctx->offset = offset;
+	ctx->len = len;
+
+	return count;
+}
+
+static inline bool josh_open_container(struct josh_ctx_t *ctx, bool is_object) {
+	// Push the array or object at the current position onto the stack of open
+	// containers. Return true if the function succeeds.
+
+	const unsigned level = ctx->depth;
+
+	if (level == JOSH_CONFIG_MAX_NESTING) {
+		JOSH_ERROR(ctx, JOSH_ERROR_MAX_NESTING_REACHED);
+
+		return false;
+	}
+
+	const uint64_t bit = (uint64_t)1 << (level % 64);
+
+	if (is_object) ctx->objects[level / 64] |= bit;
+	else ctx->objects[level / 64] &= ~bit;
+
+	if (level < JOSH_CONFIG_MAX_DEPTH) {
+		ctx->frames[level].active = ctx->active;
+		ctx->frames[level].found = 0;
+		ctx->frames[level].index = 0;
+		ctx->frames[level].hint = 0;
+	}
+
+	ctx->depth++;
+
+	josh_step_char(ctx);
+	josh_iter_whitespace(ctx);
+
+	// Slices counting from the end of this array need to know its length
+	// before any of its children can be matched.
+	if (!is_object && level < JOSH_CONFIG_MAX_DEPTH && (ctx->active & ctx->from_end)) {
+		for (uint64_t mask = ctx->active & ctx->from_end; mask; mask &= mask - 1) {
+			const struct josh_path_t *path = &ctx->paths[josh_ctz64(mask)];
+
+			if (level < path->key_count && josh_slice_from_end(path, level)) {
+				ctx->frames[level].hint = josh_count_children(ctx);
+
+				break;
+			}
+		}
+	}
+
+	if (ctx->create_node) {
+		const unsigned index = ctx->node_count;
+		struct josh_node_t *node = josh_alloc_node(ctx, is_object ? JOSH_NODE_TYPE_OBJECT : JOSH_NODE_TYPE_ARRAY);
+
+		if (!node) return false;
+
+		node->value._container.size = ctx->open_node;
+		node->value._container.count = 0;
+		ctx->open_node = index;
+	}
+
+	return true;
+}
+
+bool josh_iter_value(struct josh_ctx_t *ctx) {
+	// Parse a JSON value from ctx, extracting any keys in `ctx->paths` which
+	// are found along the way. Return true if the function succeeds.
+	//
+	// Arrays and objects are iterated without recursing, by keeping the open
+	// containers in the context. Each pass of the loop scans one value, then
+	// closes any containers which end after it and starts the next child.
+
+	const unsigned base = ctx->depth;
+
+	for (;;) {
+		const char c = josh_peek_char(ctx, 0);
+
+		if (ctx->validation == JOSH_VALIDATION_PATH && !ctx->active && !ctx->open_targets && !ctx->create_node) {
+			if (!josh_skip_value(ctx)) return false;
+		}
+		else if (c == '[' || c == '{') {
+			if (!josh_open_container(ctx, c == '{')) return false;
+
+			if (josh_peek_char(ctx, 0) != (c == '{' ? '}' : ']')) {
+				if (!josh_begin_element(ctx)) return false;
+
+				continue;
+			}
+
+			if (!josh_close_container(ctx)) return true;
+		}
+		else if (c == '\"') {
+			const char *start = ctx->ptr;
+
+			if (!josh_iter_string(ctx)) return false;
+
+			if (ctx->create_node && !josh_alloc_string_node(ctx, JOSH_NODE_TYPE_STRING, start)) return false;
+		}
+		else if (isdigit(c) || c == '-') {
+			if (!josh_iter_number(ctx)) return false;
+		}
+		else {
+			if (!josh_iter_literal(ctx)) return false;
+		}
+
+		// A value has ended, which finishes the current child of the innermost
+		// container. Keep going until a container has another child.
+		for (;;) {
+			if (ctx->depth == base) return true;
+
+			const unsigned level = ctx->depth - 1;
+			ctx->current_level--;
+
+			if (level < JOSH_CONFIG_MAX_DEPTH && ctx->frames[level].found) {
+				const uint64_t found = ctx->frames[level].found;
+
+				josh_resolve(ctx, found, ctx->results[josh_ctz64(found)].ptr);
+				ctx->open_targets--;
+
+				if (ctx->done) return true;
+			}
+
+			if (ctx->create_node) ctx->root[ctx->open_node].value._container.count++;
+
+			const char close = josh_is_object_level(ctx, level) ? '}' : ']';
+			const char next = josh_iter_whitespace(ctx);
+
+			if (next == close) {
+				if (!josh_close_container(ctx)) return true;
+
+				continue;
+			}
+
+			if (next != ',') {
+				JOSH_ERROR(ctx, JOSH_ERROR_UNEXPECTED_CHAR);
+
+				return false;
+			}
+
+			if (level < JOSH_CONFIG_MAX_DEPTH) {
+				struct josh_frame_t *frame = &ctx->frames[level];
+				const uint64_t wildcards = frame->active & ctx->pending & ctx->wildcards;
+
+				frame->index++;
+
+				// Stop as soon as the end of a slice is passed, if possible.
+				if (wildcards) {
+					josh_finish_wildcards(ctx, josh_filter_finished(ctx->paths, wildcards, level, false, frame->index, frame->hint));
+
+					if (ctx->done) return true;
+				}
+			}
+
+			josh_step_char(ctx);
+
+			if (josh_iter_whitespace(ctx) == close) {
+#if JOSH_CONFIG_ALLOW_TRAILING_COMMA == 0
+				JOSH_ERROR(ctx, JOSH_ERROR_NO_TRAILING_COMMA);
+
+				return false;
+#else
+				if (!josh_close_container(ctx)) return true;
+
+				continue;
+#endif
+			}
+
+			if (!josh_begin_element(ctx)) return false;
+
+			break;
+		}
+	}
+}
+
+static inline bool josh_is_key_terminator(char c) {
+	return c == '[' || c == '.';
+}
+
+bool josh_parse_key(struct josh_ctx_t *ctx, const char *key) {
+	// Parse the key into `ctx->keys`. Returns false if an error occurs.
+
+	struct josh_path_t path;
+
+	const bool ok = josh_compile_key(ctx, &path, key);
+
+	memcpy(ctx->keys, path.keys, path.key_count * sizeof(struct josh_key_t));
+	ctx->key_count = path.key_count;
+
+	return ok;
+}
+
+static bool josh_compile_escaped_key(struct josh_ctx_t *ctx, struct josh_key_t *key, const char *end) {
+	// Check the escapes in the quoted object key name ending at `end`, and set
+	// the length and hash of `key` to those of its decoded name, which is what
+	// object keys in the JSON are matched against once they are decoded too.
+	// Returns false if an escape is invalid.
+
+	for (const char *c = key->str; c < end; c++) {
+		if (*c != '\\') continue;
+
+		if (c[1] == 'u') {
+			for (unsigned i = 2; i < 6; i++) {
+				if (c + i >= end || !isxdigit(c[i])) {
+					JOSH_ERROR(ctx, JOSH_ERROR_INVALID_UNICODE_ESCAPE_CODE);
+
+					return false;
+				}
+			}
+
+			c += 5;
+		}
+		else if (c + 1 < end && strchr("\\/bfnrt", c[1])) {
+			c++;
+		}
+		else {
+			JOSH_ERROR(ctx, JOSH_ERROR_INVALID_ESCAPE_CODE);
+
+			return false;
+		}
+	}
+
+	const char *raw = key->str;
+	char decoded[4];
+	unsigned len = 0;
+
+	key->num = 0;
+	key->hash = JOSH_HASH_BASIS;
+
+	while (raw < end) {
+		raw = josh_key_next(raw, decoded, &len);
+		key->hash = josh_hash_extend(key->hash, decoded, len);
+		key->num += len;
+	}
+
+	return true;
+}
+
+bool josh_compile_key(struct josh_ctx_t *ctx, struct josh_path_t *path, const char *key) {
+	// Parse the JSON extraction schema (the key) into a codified format, which
+	// can then be passed to josh_extract_compiled(). Returns false if an error
+	// occurs.
+
+	// Errors in the key aren't anywhere in the last JSON scanned, which may be
+	// gone by now, so they mustn't point into it.
+	ctx->start = ctx->ptr = NULL;
+	path->key_count = 0;
+
+	while (*key) {
+		if (path->key_count >= JOSH_CONFIG_MAX_DEPTH) {
+			JOSH_ERROR(ctx, JOSH_ERROR_KEY_MAX_DEPTH_REACHED);
+
+			return false;
+		}
+
+		if (*key == '[') {
+			if (key[1] == '*' && key[2] == ']') {
+				path->keys[path->key_count].str = NULL;
+				path->keys[path->key_count].num = 0;
+				path->keys[path->key_count].hash = 0;
+				path->keys[path->key_count].escaped = false;
+				path->keys[path->key_count].wildcard = true;
+				path->keys[path->key_count].type = JOSH_KEY_TYPE_ARRAY;
+				path->slices[path->key_count].end = UINT_MAX;
+				path->slices[path->key_count].step = 1;
+				path->slices[path->key_count].start_from_end = false;
+				path->slices[path->key_count].end_from_end = false;
+				path->key_count++;
+
+				key += 3;
+			}
+			else if (isdigit(key[1]) || key[1] == ':' || key[1] == '-') {
+				// Either an index, or a slice where the start, end and step are
+				// separated by colons, and default to 0, the end and 1. A minus
+				// sign counts the start or end back from the end of the array.
+				unsigned parts[3] = { 0, UINT_MAX, 1 };
+				bool negative[3] = { false, false, false };
+				unsigned part = 0;
+				unsigned value = 0;
+				bool has_digits = false;
+				key++;
+
+				for (;;) {
+					const char c = *key++;
+
+					if (c == ']' || c == ':') {
+						if (negative[part] && !has_digits) {
+							JOSH_ERROR(ctx, JOSH_ERROR_KEY_NUMBER_INVALID);
+
+							return false;
+						}
+
+						if (has_digits) parts[part] = value;
+						if (c == ']') break;
+
+						if (++part == 3) {
+							JOSH_ERROR(ctx, JOSH_ERROR_KEY_NUMBER_INVALID);
+
+							return false;
+						}
+
+						value = 0;
+						has_digits = false;
+
+						continue;
+					}
+
+					// Only the start and end can be negative, not the step.
+					if (c == '-' && !has_digits && !negative[part] && part < 2) {
+						negative[part] = true;
+
+						continue;
+					}
+
+					if (!c) {
+						JOSH_ERROR(ctx, JOSH_ERROR_EXPECTED_KEY_CLOSING_BRACKET);
+
+						return false;
+					}
+
+					if (c < '0' || c > '9') {
+						JOSH_ERROR(ctx, JOSH_ERROR_KEY_NUMBER_INVALID);
+
+						return false;
+					}
+
+					value = (value * 10) + ((unsigned)c - '0');
+					has_digits = true;
+				}
+
+				// There is nothing before the end of the array to count from.
+				if (!parts[2] || (!part && negative[0] && !parts[0])) {
+					JOSH_ERROR(ctx, JOSH_ERROR_KEY_NUMBER_INVALID);
+
+					return false;
+				}
+
+				// An index counting from the end is the slice of just that
+				// child, as where it is isn't known until the array is scanned.
+				if (!part && negative[0]) {
+					parts[1] = parts[0] - 1;
+					negative[1] = true;
+					part = 1;
+				}
+
+				path->keys[path->key_count].num = parts[0];
+				path->keys[path->key_count].escaped = false;
+				path->keys[path->key_count].wildcard = part > 0;
+				path->keys[path->key_count].type = JOSH_KEY_TYPE_ARRAY;
+				path->slices[path->key_count].end = parts[1];
+				path->slices[path->key_count].step = parts[2];
+				path->slices[path->key_count].start_from_end = negative[0];
+				path->slices[path->key_count].end_from_end = negative[1];
+				path->key_count++;
+			}
+			else if (key[1] == '\"') {
+				const char *string_end = strchr(key + 2, '\"');
+
+				if (!string_end) {
+					JOSH_ERROR(ctx, JOSH_ERROR_EXPECTED_KEY_CLOSING_QUOTE);
+
+					return false;
+				}
+
+				const unsigned len = (unsigned)(string_end - key - 2);
+
+				if (key[len + 3] != ']') {
+					JOSH_ERROR(ctx, JOSH_ERROR_EXPECTED_KEY_CLOSING_BRACKET);
+
+					return false;
+				}
+
+				struct josh_key_t *object_key = &path->keys[path->key_count];
+
+				object_key->str = key + 2;
+				object_key->num = len;
+				object_key->hash = josh_hash(key + 2, len);
+				object_key->escaped = memchr(key + 2, '\\', len) != NULL;
+				object_key->wildcard = false;
+				object_key->type = JOSH_KEY_TYPE_OBJECT;
+				path->key_count++;
+
+				if (object_key->escaped && !josh_compile_escaped_key(ctx, object_key, key + 2 + len)) return false;
+
+				key += len + 4;
+			}
+			else {
+				JOSH_ERROR(ctx, JOSH_ERROR_EXPECTED_KEY_VALUE);
+
+				return false;
+			}
+		}
+		else if (*key == '.' && key[1] == '*' && (!key[2] || josh_is_key_terminator(key[2]))) {
+			path->keys[path->key_count].str = NULL;
+			path->keys[path->key_count].num = 0;
+			path->keys[path->key_count].hash = 0;
+			path->keys[path->key_count].escaped = false;
+			path->keys[path->key_count].wildcard = true;
+			path->keys[path->key_count].type = JOSH_KEY_TYPE_OBJECT;
+			path->key_count++;
+
+			key += 2;
+		}
+		else if (*key == '.') {
+			if (!key[1]) {
+				JOSH_ERROR(ctx, JOSH_ERROR_INVALID_KEY_OBJECT);
+
+				return false;
+			}
+
+			const char *start = key + 1;
+			char c = 0;
+
+			while ((c = *(++key))) {
+				if (
+					c == '_' ||
+					(c >= 'A' && c <= 'Z') ||
+					(c >= 'a' && c <= 'z') ||
+					(c >= '0' && c <= '9')
+				) {
+					continue;
+				}
+
+				if (josh_is_key_terminator(c)) break;
+
+				JOSH_ERROR(ctx, JOSH_ERROR_INVALID_KEY_OBJECT);
+
+				return false;
+			}
+
+			const unsigned len = (unsigned)(key - start);
+
+			path->keys[path->key_count].str = start;
+			path->keys[path->key_count].num = len;
+			path->keys[path->key_count].hash = josh_hash(start, len);
+			path->keys[path->key_count].escaped = false;
+			path->keys[path->key_count].wildcard = false;
+			path->keys[path->key_count].type = JOSH_KEY_TYPE_OBJECT;
+			path->key_count++;
+		}
+		else {
+			// should be impossible
+
+			return false;
+		}
+	}
+
+	return true;
+}
+
+#if JOSH_CONFIG_USE_SIMD && (defined(__AVX2__) || defined(__SSE2__))
+static inline const char *josh_bounded_block(const char *block, size_t size, const char *start, const char *end, void *copy) {
+	// Return the aligned `block` of `size` chars to scan, which is `block`
+	// itself unless the input is bounded (`end` is set) and part of the block
+	// is outside of `start` to `end`. Then only the part inside is copied to
+	// `copy`, with the rest zeroed, which the scanners never report.
+
+	const uintptr_t from = (uintptr_t)block;
+
+	if (!end || (from >= (uintptr_t)start && (uintptr_t)end - from >= size)) return block;
+
+	const uintptr_t first = from < (uintptr_t)start ? (uintptr_t)start : from;
+	const uintptr_t last = (uintptr_t)end - from < size ? (uintptr_t)end : from + size;
+
+	memset(copy, 0, size);
+	if (first < last) memcpy((char *)copy + (first - from), block + (first - from), last - first);
+
+	return copy;
+}
+#endif
+
+JOSH_NO_SANITIZE_ADDRESS
+static inline const char *josh_find_string_special(const char *ptr, const char *start, const char *end) {
+	// Return a pointer to the first quote, backslash, or NUL char at or after
+	// `ptr`, checking a whole block of chars at a time when possible. Stop at
+	// `end` unless it is NULL, in which case the input (from `start`) is never
+	// read past it.
+
+#if JOSH_CONFIG_USE_SIMD && defined(__AVX2__)
+	const unsigned offset = (unsigned)((uintptr_t)ptr & 31);
+	const char *block = ptr - offset;
+
+	const __m256i quote = _mm256_set1_epi8('\"');
+	const __m256i backslash = _mm256_set1_epi8('\\');
+	const __m256i zero = _mm256_setzero_si256();
+
+	const uintptr_t limit = end ? (uintptr_t)end : UINTPTR_MAX;
+	uint32_t skip = ~(uint32_t)0 << offset;
+
+	for (;; block += 32) {
+		if ((uintptr_t)block >= limit) return end;
+
+		__m256i copy;
+		const char *data = josh_bounded_block(block, 32, start, end, &copy);
+		const __m256i chunk = _mm256_load_si256((const __m256i *)(const void *)data);
+
+		const __m256i special = _mm256_or_si256(
+			_mm256_or_si256(
+				_mm256_cmpeq_epi8(chunk, quote),
+				_mm256_cmpeq_epi8(chunk, backslash)
+			),
+			_mm256_cmpeq_epi8(chunk, zero)
+		);
+
+		const uint32_t mask = (uint32_t)_mm256_movemask_epi8(special) & skip;
+		if (mask) {
+			const char *found = block + josh_ctz64(mask);
+
+			return (uintptr_t)found < limit ? found : end;
+		}
+
+		skip = ~(uint32_t)0;
+	}
+#elif JOSH_CONFIG_USE_SIMD && defined(__SSE2__)
+	const unsigned offset = (unsigned)((uintptr_t)ptr & 15);
+	const char *block = ptr - offset;
+
+	const __m128i quote = _mm_set1_epi8('\"');
+	const __m128i backslash = _mm_set1_epi8('\\');
+	const __m128i zero = _mm_setzero_si128();
+
+	const uintptr_t limit = end ? (uintptr_t)end : UINTPTR_MAX;
+	uint32_t skip = ~(uint32_t)0 << offset;
+
+	for (;; block += 16) {
+		if ((uintptr_t)block >= limit) return end;
+
+		__m128i copy;
+		const char *data = josh_bounded_block(block, 16, start, end, &copy);
+		const __m128i chunk = _mm_load_si128((const __m128i *)(const void *)data);
+
+		const __m128i special = _mm_or_si128(
+			_mm_or_si128(
+				_mm_cmpeq_epi8(chunk, quote),
+				_mm_cmpeq_epi8(chunk, backslash)
+			),
+			_mm_cmpeq_epi8(chunk, zero)
+		);
+
+		const uint32_t mask = (uint32_t)_mm_movemask_epi8(special) & skip;
+		if (mask) {
+			const char *found = block + josh_ctz64(mask);
+
+			return (uintptr_t)found < limit ? found : end;
+		}
+
+		skip = ~(uint32_t)0;
+	}
+#else
+	(void)start;
+
+	while (ptr != end && *ptr && *ptr != '\"' && *ptr != '\\') ptr++;
+
+	return ptr;
+#endif
+}
+
+JOSH_NO_SANITIZE_ADDRESS
+static inline const char *josh_find_structural(const char *ptr, const char *start, const char *end) {
+	// Return a pointer to the first quote, bracket, brace, or NUL char at or
+	// after `ptr`, stopping at `end` unless it is NULL (like
+	// josh_find_string_special()). Brackets and braces only differ by 0x20, so
+	// each pair is found with a single compare.
+
+#if JOSH_CONFIG_USE_SIMD && (defined(__AVX2__) || defined(__SSE2__))
+#if defined(__AVX2__)
+#define JOSH_BLOCK_SIZE 32
+	typedef __m256i block_t;
+#define JOSH_LOAD(block) _mm256_load_si256((const __m256i *)(const void *)(block))
+#define JOSH_SPLAT(c) _mm256_set1_epi8(c)
+#define JOSH_EQ(a, b) _mm256_cmpeq_epi8((a), (b))
+#define JOSH_OR(a, b) _mm256_or_si256((a), (b))
+#define JOSH_MASK(a) (uint32_t)_mm256_movemask_epi8(a)
+#else
+#define JOSH_BLOCK_SIZE 16
+	typedef __m128i block_t;
+#define JOSH_LOAD(block) _mm_load_si128((const __m128i *)(const void *)(block))
+#define JOSH_SPLAT(c) _mm_set1_epi8(c)
+#define JOSH_EQ(a, b) _mm_cmpeq_epi8((a), (b))
+#define JOSH_OR(a, b) _mm_or_si128((a), (b))
+#define JOSH_MASK(a) (uint32_t)_mm_movemask_epi8(a)
+#endif
+
+	const unsigned offset = (unsigned)((uintptr_t)ptr & (JOSH_BLOCK_SIZE - 1));
+	const char *block = ptr - offset;
+	const uintptr_t limit = end ? (uintptr_t)end : UINTPTR_MAX;
+
+	const block_t quote = JOSH_SPLAT('\"');
+	const block_t open = JOSH_SPLAT('{');
+	const block_t close = JOSH_SPLAT('}');
+	const block_t zero = JOSH_SPLAT(0);
+	const block_t fold = JOSH_SPLAT(0x20);
+
+	uint32_t skip = ~(uint32_t)0 << offset;
+
+	for (;; block += JOSH_BLOCK_SIZE) {
+		if ((uintptr_t)block >= limit) return end;
+
+		block_t copy;
+		const block_t chunk = JOSH_LOAD(josh_bounded_block(block, JOSH_BLOCK_SIZE, start, end, &copy));
+		const block_t folded = JOSH_OR(chunk, fold);
+
+		const block_t structural = JOSH_OR(
+			JOSH_OR(JOSH_EQ(chunk, quote), JOSH_EQ(chunk, zero)),
+			JOSH_OR(JOSH_EQ(folded, open), JOSH_EQ(folded, close))
+		);
+
+		const uint32_t mask = JOSH_MASK(structural) & skip;
+
+		if (mask) {
+			const char *found = block + josh_ctz64(mask);
+
+			return (uintptr_t)found < limit ? found : end;
+		}
+
+		skip = ~(uint32_t)0;
+	}
+
+#undef JOSH_BLOCK_SIZE
+#undef JOSH_LOAD
+#undef JOSH_SPLAT
+#undef JOSH_EQ
+#undef JOSH_OR
+#undef JOSH_MASK
+#else
+	(void)start;
+
+	while (ptr != end && *ptr && *ptr != '\"' && (*ptr | 0x20) != '{' && (*ptr | 0x20) != '}') ptr++;
+
+	return ptr;
+#endif
+}
+
+static bool josh_skip_string(struct josh_ctx_t *ctx) {
+	// Step past the string at the current position without validating its
+	// escapes. Return true if the function succeeds.
+
+	josh_step_char(ctx);
+
+	for (;;) {
+		const char *special = josh_find_string_special(ctx->ptr, ctx->start, ctx->end);
+		const char c = josh_step_n_chars(ctx, (unsigned)(special - ctx->ptr));
+
+		if (c == '\"') {
+			josh_step_char(ctx);
+
+			return true;
+		}
+
+		// Skip the backslash and the char it escapes.
+		if (!c || !josh_step_char(ctx)) {
+			JOSH_ERROR(ctx, JOSH_ERROR_STRING_NOT_CLOSED);
+
+			return false;
+		}
+
+		josh_step_char(ctx);
+	}
+}
+
+static bool josh_skip_value(struct josh_ctx_t *ctx) {
+	// Step past the value at the current position by only matching up quotes
+	// and brackets, for values which no key is looking in (see
+	// JOSH_VALIDATION_PATH). Return true if the function succeeds.
+
+#if !JOSH_CONFIG_LAZY_POSITION
+	const char *start = ctx->ptr;
+#endif
+	char c = josh_peek_char(ctx, 0);
+	bool ok = true;
+
+	if (c == '\"') {
+		ok = josh_skip_string(ctx);
+	}
+	else if ((c | 0x20) != '{') {
+		while (!josh_is_value_terminator(c)) c = josh_step_char(ctx);
+	}
+	else {
+		unsigned depth = 0;
+
+		for (;;) {
+			const char *structural = josh_find_structural(ctx->ptr, ctx->start, ctx->end);
+			c = josh_step_n_chars(ctx, (unsigned)(structural - ctx->ptr));
+
+			if (c == '\"') {
+				if (!(ok = josh_skip_string(ctx))) break;
+
+				continue;
+			}
+
+			if (!c) {
+				JOSH_ERROR(ctx, JOSH_ERROR_UNEXPECTED_CHAR);
+				ok = false;
+
+				break;
+			}
+
+			josh_step_char(ctx);
+
+			if ((c | 0x20) == '{') depth++;
+			else if (!--depth) break;
+		}
+	}
+
+#if !JOSH_CONFIG_LAZY_POSITION
+	// Skipped newlines weren't counted while stepping.
+	for (const char *newline = start; (newline = memchr(newline, '\n', (size_t)(ctx->ptr - newline))); newline++) {
+		ctx->line++;
+		ctx->column = (unsigned)(ctx->ptr - newline);
+	}
+#endif
+
+	return ok;
+}
+
+bool josh_iter_string(struct josh_ctx_t *ctx) {
+	// Iterate the context until the end of the current string. Return true
+	// if the function succeeds.
+
+	josh_step_char(ctx);
+	ctx->has_escapes = false;
+
+	for (;;) {
+		const char *special = josh_find_string_special(ctx->ptr, ctx->start, ctx->end);
+		char c = josh_step_n_chars(ctx, (unsigned)(special - ctx->ptr));
+
+		if (c == '\"') {
+			josh_step_char(ctx);
+
+			return true;
+		}
+
+		if (!c) {
+			JOSH_ERROR(ctx, JOSH_ERROR_STRING_NOT_CLOSED);
+
+			return false;
+		}
+
+		// Escapes are rare, so they are validated one char at a time.
+		ctx->has_escapes = true;
+		c = josh_step_char(ctx);
+
+		if (
+			c == '\"' ||
+			c == '\\' ||
+			c == '/' ||
+			c == 'b' ||
+			c == 'f' ||
+			c == 'n' ||
+			c == 't' ||
+			c == 'r'
+		) {
+			josh_step_char(ctx);
+
+			continue;
+		}
+
+		if (c == 'u') {
+			for (unsigned i = 0; i < 4; i++) {
+				c = josh_step_char(ctx);
+
+				if (!isxdigit(c)) {
+					JOSH_ERROR(ctx, JOSH_ERROR_INVALID_UNICODE_ESCAPE_CODE);
+
+					return false;
+				}
+			}
+
+			josh_step_char(ctx);
+
+			continue;
+		}
+
+		JOSH_ERROR(ctx, JOSH_ERROR_INVALID_ESCAPE_CODE);
+
+		return false;
+	}
+}
+
+bool josh_iter_number(struct josh_ctx_t *ctx) {
+	// Iterate the context until the end of the current number. Return true
+	// if the function succeeds.
+	//
+	// The decimal mantissa and exponent are accumulated while scanning, so
+	// floating point values can be converted without rescanning the digits.
+
+	const char *start = ctx->ptr;
+
+	const bool negative = josh_peek_char(ctx, 0) == '-';
+	char c = negative ? josh_step_char(ctx) : josh_peek_char(ctx, 0);
+	const char *started_at = ctx->ptr;
+
+	if (c == '0' && isdigit(josh_peek_char(ctx, 1))) {
+		JOSH_ERROR(ctx, JOSH_ERROR_NO_LEADING_ZERO);
+
+		return false;
+	}
+
+	// Up to 19 significant digits always fit in 64 bits. Any digits after
+	// that only shift the exponent, and mark the mantissa as truncated.
+	uint64_t mantissa = 0;
+	int digits = 0;
+	int exponent = 0;
+	bool truncated = false;
+
+#if JOSH_USE_SWAR
+	uint64_t chunk;
+
+	while (digits <= 19 - 8 && josh_has_chars(ctx, 8) && josh_parse_eight_digits(ctx->ptr, &chunk)) {
+		mantissa = mantissa * 100000000 + chunk;
+		digits += 8;
+		c = josh_step_n_chars(ctx, 8);
+	}
+#endif
+
+	while (c && isdigit(c)) {
+		if (digits < 19) {
+			mantissa = mantissa * 10 + (uint64_t)(c - '0');
+			if (mantissa) digits++;
+		}
+		else {
+			exponent++;
+			truncated |= c != '0';
+		}
+
+		c = josh_step_char(ctx);
+	}
+	if (ctx->ptr == started_at) goto fail;
+
+	bool is_floating_point = false;
+
+	if (c == '.') {
+		is_floating_point = true;
+
+		c = josh_step_char(ctx);
+
+		started_at = ctx->ptr;
+
+#if JOSH_USE_SWAR
+		// Leading zeros aren't significant, so only take whole chunks once the
+		// mantissa has some digits, to keep the digit count exact.
+		while (mantissa && digits <= 19 - 8 && josh_has_chars(ctx, 8) && josh_parse_eight_digits(ctx->ptr, &chunk)) {
+			mantissa = mantissa * 100000000 + chunk;
+			digits += 8;
+			exponent -= 8;
+			c = josh_step_n_chars(ctx, 8);
+		}
+#endif
+
+		while (c && isdigit(c)) {
+			if (digits < 19) {
+				mantissa = mantissa * 10 + (uint64_t)(c - '0');
+				if (mantissa) digits++;
+				exponent--;
+			}
+			else {
+				truncated |= c != '0';
+			}
+
+			c = josh_step_char(ctx);
+		}
+		if (ctx->ptr == started_at) goto fail;
+	}
+
+	if (c == 'e' || c == 'E') {
+		is_floating_point = true;
+
+		c = josh_step_char(ctx);
+
+		const bool negative_exponent = c == '-';
+		if (c == '-' || c == '+') c = josh_step_char(ctx);
+
+		int explicit_exponent = 0;
+
+		started_at = ctx->ptr;
+		while (c && isdigit(c)) {
+			if (explicit_exponent < 0x10000) explicit_exponent = explicit_exponent * 10 + (c - '0');
+
+			c = josh_step_char(ctx);
+		}
+		if (ctx->ptr == started_at) goto fail;
+
+		exponent += negative_exponent ? -explicit_exponent : explicit_exponent;
+	}
+
+	if (ctx->create_node) {
+		// Integers that don't fit in a long long are stored as floats instead,
+		// keeping their magnitude.
+		if (
+			!is_floating_point &&
+			(exponent || mantissa > (uint64_t)LLONG_MAX + negative)
+		) {
+			is_floating_point = true;
+		}
+
+		struct josh_node_t *node = josh_alloc_node(
+			ctx,
+			is_floating_point ? JOSH_NODE_TYPE_FLOAT : JOSH_NODE_TYPE_INT
+		);
+		if (!node) return false;
+
+		if (is_floating_point) {
+			const char *str = start;
+			char copy[64];
+
+			// The strtod() fallback would read past the end of bounded input if
+			// the number runs right up to it, so it gets a terminated copy.
+			if (ctx->end && ctx->ptr == ctx->end) {
+				const size_t len = (size_t)(ctx->ptr - start);
+				char *out = len < sizeof(copy) ? copy : josh_malloc(ctx, len + 1);
+				if (!out) return false;
+
+				memcpy(out, start, len);
+				out[len] = '\0';
+				str = out;
+			}
+
+			node->value._float = josh_decimal_to_double(str, mantissa, exponent, negative, truncated);
+		}
+		else if (negative && mantissa) {
+			node->value._int = -(long long)(mantissa - 1) - 1;
+		}
+		else {
+			node->value._int = (long long)mantissa;
+		}
+	}
+
+	if (!josh_is_value_terminator(josh_peek_char(ctx, 0))) goto fail;
+
+	return true;
+
+fail:
+	JOSH_ERROR(ctx, JOSH_ERROR_DIGIT_EXPECTED);
+
+	return false;
+}
+
+bool josh_iter_literal(struct josh_ctx_t *ctx) {
+	// Iterate to the end of a JSON literal, such as null, true, or false. Return
+	// true if the function succeeds.
+
+	const char c = josh_peek_char(ctx, 0);
+
+	if (c == 't') {
+		if (!josh_match_literal(ctx, "true", 4)) {
+			JOSH_ERROR(ctx, JOSH_ERROR_EXPECTED_TRUE);
+
+			return false;
+		}
+
+		if (ctx->create_node) {
+			if (!josh_alloc_node(ctx, JOSH_NODE_TYPE_TRUE)) return false;
+		}
+
+		josh_step_n_chars(ctx, 4);
+	}
+	else if (c == 'f') {
+		if (!josh_match_literal(ctx, "false", 5)) {
+			JOSH_ERROR(ctx, JOSH_ERROR_EXPECTED_FALSE);
+
+			return false;
+		}
+
+		if (ctx->create_node) {
+			if (!josh_alloc_node(ctx, JOSH_NODE_TYPE_FALSE)) return false;
+		}
+
+		josh_step_n_chars(ctx, 5);
+	}
+	else if (c == 'n') {
+		if (!josh_match_literal(ctx, "null", 4)) {
+			JOSH_ERROR(ctx, JOSH_ERROR_EXPECTED_NULL);
+
+			return false;
+		}
+
+		if (ctx->create_node) {
+			if (!josh_alloc_node(ctx, JOSH_NODE_TYPE_NULL)) return false;
+		}
+
+		josh_step_n_chars(ctx, 4);
+	}
+	else {
+		JOSH_ERROR(ctx, JOSH_ERROR_EXPECTED_LITERAL);
+
+		return false;
+	}
+
+	return true;
+}
+
+static inline bool josh_is_whitespace(char c) {
+	return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\f';
+}
+
+#if JOSH_CONFIG_USE_SIMD && (defined(__AVX2__) || defined(__SSE2__))
+JOSH_NO_SANITIZE_ADDRESS
+static char josh_iter_whitespace_simd(struct josh_ctx_t *ctx) {
+	// Skip a run of whitespace one block at a time, counting the newlines in
+	// each block instead of checking every char (unless the position is being
+	// computed lazily). Bounded input is never read outside of its bounds.
+
+#if defined(__AVX2__)
+#define JOSH_BLOCK_SIZE 32
+	typedef __m256i block_t;
+#define JOSH_LOAD(block) _mm256_load_si256((const __m256i *)(const void *)(block))
+#define JOSH_SPLAT(c) _mm256_set1_epi8(c)
+#define JOSH_EQ(a, b) _mm256_cmpeq_epi8((a), (b))
+#define JOSH_OR(a, b) _mm256_or_si256((a), (b))
+#define JOSH_MASK(a) (uint32_t)_mm256_movemask_epi8(a)
+#else
+#define JOSH_BLOCK_SIZE 16
+	typedef __m128i block_t;
+#define JOSH_LOAD(block) _mm_load_si128((const __m128i *)(const void *)(block))
+#define JOSH_SPLAT(c) _mm_set1_epi8(c)
+#define JOSH_EQ(a, b) _mm_cmpeq_epi8((a), (b))
+#define JOSH_OR(a, b) _mm_or_si128((a), (b))
+#define JOSH_MASK(a) (uint32_t)_mm_movemask_epi8(a)
+#endif
+
+	const char *start = ctx->ptr;
+	const unsigned offset = (unsigned)((uintptr_t)start & (JOSH_BLOCK_SIZE - 1));
+	const char *block = start - offset;
+
+	const block_t space = JOSH_SPLAT(' ');
+	const block_t newline = JOSH_SPLAT('\n');
+	const block_t carriage_return = JOSH_SPLAT('\r');
+	const block_t tab = JOSH_SPLAT('\t');
+	const block_t form_feed = JOSH_SPLAT('\f');
+
+	const uint32_t all = (uint32_t)(((uint64_t)1 << JOSH_BLOCK_SIZE) - 1);
+	const uintptr_t limit = ctx->end ? (uintptr_t)ctx->end : UINTPTR_MAX;
+
+	// Chars before `start` are treated as whitespace, but not newlines.
+	uint32_t before = ~(~(uint32_t)0 << offset);
+
+#if !JOSH_CONFIG_LAZY_POSITION
+	const char *last_newline = NULL;
+	unsigned lines = 0;
+#endif
+
+	for (;; block += JOSH_BLOCK_SIZE) {
+		// Bounded input must not be read past its end, which is treated as the
+		// first non whitespace char.
+		if ((uintptr_t)block >= limit) {
+			ctx->ptr = ctx->end;
+			break;
+		}
+
+		uint32_t beyond = 0;
+
+		if (limit - (uintptr_t)block < JOSH_BLOCK_SIZE) {
+			beyond = all & ~(uint32_t)(((uint64_t)1 << (limit - (uintptr_t)block)) - 1);
+		}
+
+		block_t copy;
+		const block_t chunk = JOSH_LOAD(josh_bounded_block(block, JOSH_BLOCK_SIZE, ctx->start, ctx->end, &copy));
+		const block_t is_newline = JOSH_EQ(chunk, newline);
+
+		const block_t is_whitespace = JOSH_OR(
+			JOSH_OR(JOSH_EQ(chunk, space), is_newline),
+			JOSH_OR(
+				JOSH_OR(JOSH_EQ(chunk, carriage_return), JOSH_EQ(chunk, tab)),
+				JOSH_EQ(chunk, form_feed)
+			)
+		);
+
+		const uint32_t not_whitespace = (~(JOSH_MASK(is_whitespace) | before) | beyond) & all;
+
+#if JOSH_CONFIG_LAZY_POSITION
+		if (not_whitespace) {
+			ctx->ptr = block + josh_ctz64(not_whitespace);
+			break;
+		}
+#else
+		uint32_t newlines = JOSH_MASK(is_newline) & ~before;
+
+		if (not_whitespace) {
+			const unsigned end = josh_ctz64(not_whitespace);
+			newlines &= (uint32_t)(((uint64_t)1 << end) - 1);
+
+			if (newlines) {
+				lines += josh_popcount64(newlines);
+				last_newline = block + josh_msb64(newlines);
+			}
+
+			ctx->ptr = block + end;
+			break;
+		}
+
+		if (newlines) {
+			lines += josh_popcount64(newlines);
+			last_newline = block + josh_msb64(newlines);
+		}
+#endif
+
+		before = 0;
+	}
+
+#if !JOSH_CONFIG_LAZY_POSITION
+	if (last_newline) {
+		ctx->line += lines;
+		ctx->column = (unsigned)(ctx->ptr - last_newline);
+	}
+	else {
+		ctx->column += (unsigned)(ctx->ptr - start);
+	}
+#endif
+
+	return josh_peek_char(ctx, 0);
+
+#undef JOSH_BLOCK_SIZE
+#undef JOSH_LOAD
+#undef JOSH_SPLAT
+#undef JOSH_EQ
+#undef JOSH_OR
+#undef JOSH_MASK
+}
+#endif
+
+static inline char josh_iter_whitespace(struct josh_ctx_t *ctx) {
+	// Iterate context to next non whitespace character.
+
+	char c = josh_peek_char(ctx, 0);
+
+	if (!josh_is_whitespace(c)) return c;
+
+	// Most values are separated by a single space, so only use the block
+	// scanner for longer runs of whitespace.
+	if (!josh_is_whitespace(josh_peek_char(ctx, 1))) {
+#if !JOSH_CONFIG_LAZY_POSITION
+		if (c == '\n') {
+			ctx->line++;
+			ctx->column = 0;
+		}
+#endif
+
+		return josh_step_char(ctx);
+	}
+
+#if JOSH_CONFIG_USE_SIMD && (defined(__AVX2__) || defined(__SSE2__))
+	return josh_iter_whitespace_simd(ctx);
+#else
+	while (josh_is_whitespace(c)) {
+#if !JOSH_CONFIG_LAZY_POSITION
+		if (c == '\n') {
+			ctx->line++;
+			ctx->column = 0;
+		}
+#endif
+
+		c = josh_step_char(ctx);
+	}
+
+	return c;
+#endif
+}
+
+static inline char josh_step_char(struct josh_ctx_t *ctx) {
+	return josh_step_n_chars(ctx, 1);
+}
+
+static inline char josh_step_n_chars(struct josh_ctx_t *ctx, unsigned n) {
+	// Advance the context by n characters, returning the last character.
+
+	ctx->ptr += n;
+
+#if !JOSH_CONFIG_LAZY_POSITION
+	ctx->column += n;
+#endif
+
+	return josh_peek_char(ctx, 0);
+}
+
+static inline char josh_peek_char(const struct josh_ctx_t *ctx, size_t n) {
+	// Return the char `n` places after the current position, or NUL if that is
+	// past the end of length-bounded input.
+
+	if (ctx->end && (size_t)(ctx->end - ctx->ptr) <= n) return '\0';
+
+	return ctx->ptr[n];
+}
+
+static inline bool josh_has_chars(const struct josh_ctx_t *ctx, size_t n) {
+	// Return true if `n` chars can be read from the current position. Only
+	// length-bounded input is checked, NUL terminated input is assumed to be
+	// handled by the caller.
+
+	return !ctx->end || (size_t)(ctx->end - ctx->ptr) >= n;
+}
+
+static inline bool josh_match_literal(const struct josh_ctx_t *ctx, const char *literal, size_t len) {
+	// Return true if the input at the current position starts with `literal`.
+
+	if (ctx->end) return josh_has_chars(ctx, len) && memcmp(ctx->ptr, literal, len) == 0;
+
+	return strncmp(ctx->ptr, literal, len) == 0;
+}
+
+void josh_error_position(const struct josh_ctx_t *ctx, unsigned *line, unsigned *column) {
+	// Work out the line and column of `ctx->offset` (where the last error
+	// occurred), both starting at 1.
+
+	*line = 1;
+	*column = (unsigned)ctx->offset + 1;
+
+	if (!ctx->offset || !ctx->start) return;
+
+	const char *ptr = ctx->start;
+	const char *end = ctx->start + ctx->offset;
+
+	while ((ptr = memchr(ptr, '\n', (size_t)(end - ptr)))) {
+		ptr++;
+		(*line)++;
+		*column = (unsigned)(end - ptr) + 1;
+	}
+}
+
+void *josh_malloc(struct josh_ctx_t *ctx, size_t bytes) {
+	// Allocate `bytes` from the arena of the context, returning NULL if the
+	// context has no arena or it is out of memory.
+
+	void *memory = ctx->arena ? josh_arena_alloc(ctx->arena, bytes, 1) : NULL;
+
+	if (!memory) {
+		JOSH_ERROR(ctx, JOSH_ERROR_OUT_OF_MEMORY);
+	}
+
+	return memory;
+}
+
+static inline char *josh_encode_utf8(char *out, unsigned codepoint) {
+	// Write `codepoint` to `out` as UTF-8, returning the end of what was written.
+
+	if (codepoint < 0x80) {
+		*out++ = (char)codepoint;
+	}
+	else if (codepoint < 0x800) {
+		*out++ = (char)(0xc0 | (codepoint >> 6));
+		*out++ = (char)(0x80 | (codepoint & 0x3f));
+	}
+	else if (codepoint < 0x10000) {
+		*out++ = (char)(0xe0 | (codepoint >> 12));
+		*out++ = (char)(0x80 | ((codepoint >> 6) & 0x3f));
+		*out++ = (char)(0x80 | (codepoint & 0x3f));
+	}
+	else {
+		*out++ = (char)(0xf0 | (codepoint >> 18));
+		*out++ = (char)(0x80 | ((codepoint >> 12) & 0x3f));
+		*out++ = (char)(0x80 | ((codepoint >> 6) & 0x3f));
+		*out++ = (char)(0x80 | (codepoint & 0x3f));
+	}
+
+	return out;
+}
+
+size_t josh_unescape(char *out, const char *str, size_t len) {
+	// Decode the escapes in the (already validated) string contents `str` of
+	// `len` bytes into `out`, returning the length of the result. The result is
+	// never longer than the input, so `out` needs room for `len` bytes. Runs of
+	// chars between escapes are found with memchr() and copied with memcpy(),
+	// which are vectorized by most C libraries. Unpaired surrogates are replaced
+	// with U+FFFD.
+
+	const char *end = str + len;
+	char *start = out;
+
+	for (;;) {
+		const char *backslash = memchr(str, '\\', (size_t)(end - str));
+		const size_t run = (size_t)((backslash ? backslash : end) - str);
+
+		memcpy(out, str, run);
+		out += run;
+
+		if (!backslash) return (size_t)(out - start);
+
+		str = backslash + 2;
+
+		switch (backslash[1]) {
+			case 'b': *out++ = '\b'; break;
+			case 'f': *out++ = '\f'; break;
+			case 'n': *out++ = '\n'; break;
+			case 'r': *out++ = '\r'; break;
+			case 't': *out++ = '\t'; break;
+			case 'u': {
+				unsigned codepoint = josh_parse_hex4(str);
+				str += 4;
+
+				if (codepoint >= 0xd800 && codepoint <= 0xdbff) {
+					unsigned low = 0;
+
+					if (end - str >= 6 && str[0] == '\\' && str[1] == 'u') {
+						low = josh_parse_hex4(str + 2);
+					}
+
+					if (low >= 0xdc00 && low <= 0xdfff) {
+						codepoint = 0x10000 + ((codepoint - 0xd800) << 10) + (low - 0xdc00);
+						str += 6;
+					}
+					else {
+						codepoint = 0xfffd;
+					}
+				}
+				else if (codepoint >= 0xdc00 && codepoint <= 0xdfff) {
+					codepoint = 0xfffd;
+				}
+
+				out = josh_encode_utf8(out, codepoint);
+
+				break;
+			}
+			default: *out++ = backslash[1]; break;
+		}
+	}
+}
+
+const char *josh_string_value(
+	struct josh_ctx_t *ctx,
+	const char *json,
+	const struct josh_node_t *node,
+	size_t *len
+) {
+	// Return the contents of the string or key `node` from the JSON `json` it
+	// was parsed from, storing its length in `len`. Strings without escapes
+	// point straight into `json`, and the rest are unescaped into the arena of
+	// the context. The result is not NUL terminated. Returns NULL if out of
+	// memory.
+
+	const char *str = josh_string_ptr(json, node);
+
+	if (!josh_string_has_escapes(node)) {
+		*len = josh_string_len(node);
+
+		return str;
+	}
+
+	char *out = josh_malloc(ctx, josh_string_len(node));
+	if (!out) return NULL;
+
+	*len = josh_unescape(out, str, josh_string_len(node));
+
+	return out;
+}
+
+static inline struct josh_node_t *josh_alloc_node(struct josh_ctx_t *ctx, enum josh_node_type_t type) {
+	// Append a node of `type` to the tape, growing it if needed. The returned
+	// pointer is only valid until the next node is allocated, since growing
+	// the tape can move it.
+
+	if (ctx->node_count == ctx->node_capacity) {
+		unsigned capacity = ctx->node_capacity ? ctx->node_capacity * 2 : 16;
+
+		// Use up the rest of the current block before doubling into a new one,
+		// since moving the tape leaves the old copy behind until the next reset.
+		const size_t room = ctx->arena ? josh_arena_room(
+			ctx->arena,
+			ctx->root,
+			ctx->node_capacity * sizeof(struct josh_node_t),
+			JOSH_ALIGNOF(struct josh_node_t)
+		) / sizeof(struct josh_node_t) : 0;
+
+		if (room > ctx->node_capacity && room < capacity) capacity = (unsigned)room;
+
+		struct josh_node_t *tape = ctx->arena ? josh_arena_realloc(
+			ctx->arena,
+			ctx->root,
+			ctx->node_capacity * sizeof(struct josh_node_t),
+			capacity * sizeof(struct josh_node_t),
+			JOSH_ALIGNOF(struct josh_node_t)
+		) : NULL;
+
+		if (!tape) {
+			JOSH_ERROR(ctx, JOSH_ERROR_OUT_OF_MEMORY);
+
+			return NULL;
+		}
+
+		ctx->root = tape;
+		ctx->node_capacity = capacity;
+	}
+
+	struct josh_node_t *node = &ctx->root[ctx->node_count++];
+
+	node->type = (unsigned)type & 0xf;
+
+	return node;
+}
+
+static inline struct josh_node_t *josh_alloc_string_node(
+	struct josh_ctx_t *ctx,
+	enum josh_node_type_t type,
+	const char *start
+) {
+	// Append a string or key node for the string starting at the quote `start`
+	// and ending just before the current position.
+
+	// Only josh_parse_n() knows the length up front, so NUL terminated
+	// documents are checked as they go.
+	if ((size_t)(ctx->ptr - ctx->start) > UINT32_MAX) {
+		JOSH_ERROR(ctx, JOSH_ERROR_DOCUMENT_TOO_LARGE);
+
+		return NULL;
+	}
+
+	struct josh_node_t *node = josh_alloc_node(ctx, type);
+	if (!node) return NULL;
+
+	node->value._string.offset = (uint32_t)(start + 1 - ctx->start);
+	node->value._string.len = (uint32_t)(ctx->ptr - start - 2);
+	node->has_escapes = ctx->has_escapes;
+
+	return node;
+}
+
+static inline void josh_close_container_node(struct josh_ctx_t *ctx, unsigned index, unsigned count) {
+	// Record the size of the container at `index` on the tape, now that all
+	// of its `count` children have been added.
+
+	struct josh_node_t *node = &ctx->root[index];
+
+	node->value._container.size = ctx->node_count - index;
+	node->value._container.count = count;
+}
+
+// Size of the block header, rounded up so that block data is always aligned.
+#define JOSH_ARENA_HEADER_SIZE \
+	((sizeof(struct josh_arena_block_t) + 15) & ~(size_t)15)
+
+static void *josh_default_alloc(void *user, size_t bytes) {
+	(void)user;
+
+	return malloc(bytes);
+}
+
+static void josh_default_free(void *user, void *ptr) {
+	(void)user;
+
+	free(ptr);
+}
+
+void josh_arena_init(struct josh_arena_t *arena, void *buffer, size_t size) {
+	// Setup an arena, optionally using `buffer` as the first block. The arena
+	// will grow using malloc() by default, and is limited to handing out
+	// JOSH_CONFIG_MAX_MEMORY bytes between resets. These can be changed by
+	// setting the `alloc`, `free`, `block_size`, and `limit` fields.
+
+	arena->alloc = josh_default_alloc;
+	arena->free = josh_default_free;
+	arena->user = NULL;
+	arena->block_size = JOSH_CONFIG_ARENA_BLOCK_SIZE;
+	arena->limit = JOSH_CONFIG_MAX_MEMORY;
+	arena->head = arena->current = NULL;
+	arena->used = 0;
+	arena->allocated = 0;
+	arena->high_water = 0;
+
+	if (!buffer) return;
+
+	// Align the block header, since the caller's buffer might not be.
+	const size_t padding = (size_t)(-(uintptr_t)buffer & 15);
+
+	if (size < padding + JOSH_ARENA_HEADER_SIZE) return;
+
+	struct josh_arena_block_t *block = (void *)((uint8_t *)buffer + padding);
+
+	block->next = NULL;
+	block->size = size - padding - JOSH_ARENA_HEADER_SIZE;
+	block->owned = false;
+
+	arena->head = arena->current = block;
+}
+
+void josh_arena_reset(struct josh_arena_t *arena) {
+	// Mark all memory in the arena as unused. Blocks are kept for reuse.
+
+	arena->current = arena->head;
+	arena->used = 0;
+	arena->allocated = 0;
+}
+
+void josh_arena_free(struct josh_arena_t *arena) {
+	// Free all blocks allocated by the arena. The arena can be reused after.
+
+	struct josh_arena_block_t *block = arena->head;
+	arena->head = NULL;
+
+	while (block) {
+		struct josh_arena_block_t *next = block->next;
+
+		if (block->owned) {
+			arena->free(arena->user, block);
+		}
+		else {
+			// Only the first block can be a buffer supplied by the caller.
+			block->next = NULL;
+			arena->head = block;
+		}
+
+		block = next;
+	}
+
+	josh_arena_reset(arena);
+}
+
+void *josh_arena_realloc(struct josh_arena_t *arena, void *ptr, size_t old_bytes, size_t new_bytes, size_t align) {
+	// Grow the allocation `ptr` from `old_bytes` to `new_bytes`. This happens
+	// in place if `ptr` is the latest allocation and its block has room left,
+	// otherwise the data is copied to a new allocation (the old one stays
+	// unused until the next reset). Returns NULL if the arena can't grow.
+	// Shrinking the latest allocation gives the rest back to the arena.
+
+	if (!ptr) return josh_arena_alloc(arena, new_bytes, align);
+
+	struct josh_arena_block_t *block = arena->current;
+	const bool latest = block && (uint8_t *)ptr + old_bytes == (uint8_t *)block + JOSH_ARENA_HEADER_SIZE + arena->used;
+
+	if (new_bytes <= old_bytes) {
+		if (latest) {
+			arena->used -= old_bytes - new_bytes;
+			arena->allocated -= old_bytes - new_bytes;
+		}
+
+		return ptr;
+	}
+
+	const size_t extra = new_bytes - old_bytes;
+
+	if (
+		latest &&
+		extra <= block->size - arena->used &&
+		(!arena->limit || extra <= arena->limit - arena->allocated)
+	) {
+		arena->used += extra;
+		arena->allocated += extra;
+
+		if (arena->allocated > arena->high_water) {
+			arena->high_water = arena->allocated;
+		}
+
+		return ptr;
+	}
+
+	void *memory = josh_arena_alloc(arena, new_bytes, align);
+	if (!memory) return NULL;
+
+	memcpy(memory, ptr, old_bytes);
+
+	return memory;
+}
+
+static size_t josh_arena_room(const struct josh_arena_t *arena, const void *ptr, size_t bytes, size_t align) {
+	// How big the allocation `ptr` of `bytes` could grow to without moving, or
+	// how big a new allocation could be without a new block if `ptr` is NULL.
+	// This is 0 if `ptr` isn't the latest allocation.
+
+	const struct josh_arena_block_t *block = arena->current;
+	if (!block) return 0;
+
+	const uint8_t *data = (const uint8_t *)block + JOSH_ARENA_HEADER_SIZE;
+	size_t start = arena->used - bytes;
+
+	if (!ptr) {
+		start = (arena->used + align - 1) & ~(align - 1);
+		if (start > block->size) return 0;
+	}
+	else if (bytes > arena->used || (const uint8_t *)ptr != data + start) {
+		return 0;
+	}
+
+	size_t room = block->size - start;
+
+	if (arena->limit) {
+		const size_t left = arena->limit - arena->allocated + bytes;
+		if (left < room) room = left;
+	}
+
+	return room;
+}
+
+void *josh_arena_alloc(struct josh_arena_t *arena, size_t bytes, size_t align) {
+	// Allocate `bytes` aligned to `align` (a power of 2, max 16) from the arena,
+	// returning NULL if the arena can't grow to fit it.
+
+	if (arena->limit && bytes > arena->limit - arena->allocated) return NULL;
+
+	for (;;) {
+		struct josh_arena_block_t *block = arena->current;
+
+		if (block) {
+			uint8_t *data = (uint8_t *)block + JOSH_ARENA_HEADER_SIZE;
+			const size_t start = (arena->used + align - 1) & ~(align - 1);
+
+			if (start <= block->size && bytes <= block->size - start) {
+				arena->used = start + bytes;
+				arena->allocated += bytes;
+
+				if (arena->allocated > arena->high_water) {
+					arena->high_water = arena->allocated;
+				}
+
+				return data + start;
+			}
+
+			// Reuse blocks from before the last reset if they are big enough.
+			if (block->next && bytes <= block->next->size) {
+				arena->current = block->next;
+				arena->used = 0;
+
+				continue;
+			}
+		}
+
+		if (!arena->alloc) return NULL;
+
+		const size_t size = bytes > arena->block_size ? bytes : arena->block_size;
+
+		struct josh_arena_block_t *new_block = arena->alloc(
+			arena->user,
+			JOSH_ARENA_HEADER_SIZE + size
+		);
+		if (!new_block) return NULL;
+
+		new_block->size = size;
+		new_block->owned = true;
+
+		if (block) {
+			new_block->next = block->next;
+			block->next = new_block;
+		}
+		else {
+			new_block->next = arena->head;
+			arena->head = new_block;
+		}
+
+		arena->current = new_block;
+		arena->used = 0;
+	}
+}
+
+// Position in the number grammar, tracked by the streaming parser in `step`.
+enum josh_stream_number_t {
+	JOSH_STREAM_NUMBER_MINUS,
+	JOSH_STREAM_NUMBER_ZERO,
+	JOSH_STREAM_NUMBER_INT,
+	JOSH_STREAM_NUMBER_DOT,
+	JOSH_STREAM_NUMBER_FRACTION,
+	JOSH_STREAM_NUMBER_E,
+	JOSH_STREAM_NUMBER_EXPONENT_SIGN,
+	JOSH_STREAM_NUMBER_EXPONENT,
+};
+
+bool josh_stream_init(
+	struct josh_stream_t *stream,
+	const struct josh_path_t *paths,
+	struct josh_result_t *results,
+	unsigned count
+) {
+	// Setup a streaming extraction of the compiled keys in `paths`, whose
+	// outcomes are stored in the same index of `results`. The document is then
+	// passed in chunks to josh_stream_feed(), followed by josh_stream_finish().
+	// The `callback`, `user`, and `arena` fields can be set after init.
+
+	stream->paths = paths;
+	stream->results = results;
+	stream->path_count = count;
+	stream->callback = NULL;
+	stream->user = NULL;
+	stream->arena = NULL;
+	stream->error_id = JOSH_ERROR_NONE;
+	stream->offset = 0;
+	stream->pending = 0;
+	stream->done = false;
+	stream->wildcards = 0;
+	stream->state = JOSH_STREAM_STATE_VALUE;
+	stream->step = 0;
+	stream->literal = NULL;
+	stream->literal_error = JOSH_ERROR_NONE;
+	stream->in_key = false;
+	stream->key_matches = 0;
+	stream->key_len = 0;
+	stream->code = 0;
+	stream->high_surrogate = 0;
+	stream->chunk = NULL;
+	stream->chunk_offset = 0;
+	stream->document_end = 0;
+	stream->capture = NULL;
+	stream->capture_start = 0;
+	stream->capture_len = 0;
+	stream->capture_capacity = 0;
+	stream->depth = 0;
+
+	if (count > JOSH_MAX_PATHS) {
+		stream->error_id = JOSH_ERROR_KEY_MAX_COUNT_REACHED;
+		stream->state = JOSH_STREAM_STATE_ERROR;
+
+		return false;
+	}
+
+	// Arrays are only seen once while streaming, too late to know their length.
+	for (unsigned i = 0; i < count; i++) {
+		if (josh_has_from_end(&paths[i])) {
+			stream->error_id = JOSH_ERROR_KEY_NOT_STREAMABLE;
+			stream->state = JOSH_STREAM_STATE_ERROR;
+
+			return false;
+		}
+	}
+
+	struct josh_stream_frame_t *document = &stream->stack[0];
+
+	document->active = 0;
+	document->found = 0;
+	document->value_start = 0;
+	document->index = 0;
+	document->is_object = false;
+
+	for (unsigned i = 0; i < count; i++) {
+		stream->pending |= (uint64_t)1 << i;
+
+		if (!paths[i].key_count) document->found |= (uint64_t)1 << i;
+		if (josh_has_wildcard(&paths[i])) stream->wildcards |= (uint64_t)1 << i;
+
+		results[i].ptr = NULL;
+		results[i].len = 0;
+		results[i].error_id = JOSH_ERROR_NONE;
+		results[i].offset = 0;
+	}
+
+	stream->done = !count;
+
+	return true;
+}
+
+static inline void josh_stream_emit(
+	struct josh_stream_t *stream,
+	uint64_t mask,
+	const char *ptr,
+	size_t start,
+	size_t len,
+	enum josh_error error_id
+) {
+	// Store the outcome of the keys in `mask`, and pass them to the callback.
+
+	for (uint64_t bits = mask; bits; bits &= bits - 1) {
+		const unsigned i = josh_ctz64(bits);
+		struct josh_result_t *result = &stream->results[i];
+
+		result->ptr = ptr;
+		result->len = len;
+		result->error_id = error_id;
+		result->offset = start;
+
+		if (stream->callback) stream->callback(stream->user, i, result);
+	}
+
+	stream->pending &= ~(stream->callback && !error_id ? mask & ~stream->wildcards : mask);
+	if (mask && !stream->pending) stream->done = true;
+}
+
+static bool josh_stream_capture(struct josh_stream_t *stream, size_t start, size_t end) {
+	// Make sure the capture buffer holds the document from `start` (or from
+	// where it already starts) up to `end`, copying from the current chunk.
+	// Return false if the bytes aren't available.
+
+	if (!stream->capture_len) stream->capture_start = start;
+
+	const size_t from = stream->capture_start + stream->capture_len;
+
+	if (stream->capture_start > start || from < stream->chunk_offset) return false;
+	if (end <= from) return true;
+
+	const size_t len = stream->capture_len + (end - from);
+
+	if (len > stream->capture_capacity) {
+		if (!stream->arena) return false;
+
+		size_t capacity = stream->capture_capacity ? stream->capture_capacity * 2 : 256;
+		while (capacity < len) capacity *= 2;
+
+		char *capture = josh_arena_realloc(stream->arena, stream->capture, stream->capture_capacity, capacity, 1);
+		if (!capture) return false;
+
+		stream->capture = capture;
+		stream->capture_capacity = capacity;
+	}
+
+	memcpy(stream->capture + stream->capture_len, stream->chunk + (from - stream->chunk_offset), end - from);
+	stream->capture_len = len;
+
+	return true;
+}
+
+static inline void josh_stream_fail(struct josh_stream_t *stream, uint64_t mask, enum josh_error error_id, size_t offset) {
+	josh_stream_emit(stream, mask, NULL, offset, 0, error_id);
+}
+
+static bool josh_stream_error(struct josh_stream_t *stream, enum josh_error error_id, size_t offset) {
+	// Stop the stream with `error_id` at `offset`, failing any keys which
+	// haven't been found yet. Always returns false.
+
+	stream->error_id = error_id;
+	stream->offset = offset;
+	stream->state = JOSH_STREAM_STATE_ERROR;
+
+	josh_stream_fail(stream, stream->pending, error_id, offset);
+
+	return false;
+}
+
+static void josh_stream_finish_wildcards(struct josh_stream_t *stream, uint64_t finished, size_t offset) {
+	// Stop looking for the keys with a wildcard in `finished`, like
+	// josh_finish_wildcards().
+
+	for (uint64_t bits = finished; bits; bits &= bits - 1) {
+		const unsigned i = josh_ctz64(bits);
+
+		if (stream->results[i].len) stream->pending &= ~(bits & -bits);
+		else josh_stream_fail(stream, bits & -bits, josh_not_found_error(&stream->paths[i]), offset);
+	}
+
+	if (finished && !stream->pending) stream->done = true;
+}
+
+static inline uint64_t josh_stream_filter_paths(
+	const struct josh_stream_t *stream,
+	uint64_t mask,
+	unsigned level,
+	enum josh_key_type_t type
+) {
+	// Return the keys in `mask` whose key at `level` is of `type`.
+
+	uint64_t out = 0;
+
+	for (uint64_t bits = mask; bits; bits &= bits - 1) {
+		if (stream->paths[josh_ctz64(bits)].keys[level].type == type) out |= bits & -bits;
+	}
+
+	return out;
+}
+
+static inline uint64_t josh_stream_begin_value(struct josh_stream_t *stream, size_t offset, char c) {
+	// Note the start of a value at `offset`, whose first char is `c`. Return
+	// the keys which should be followed into it if it is a container.
+
+	struct josh_stream_frame_t *frame = &stream->stack[stream->depth];
+
+	if (!stream->depth) {
+		const uint64_t active = stream->pending & ~frame->found;
+
+		if (c != '[') {
+			josh_stream_fail(stream, josh_stream_filter_paths(stream, active, 0, JOSH_KEY_TYPE_ARRAY), JOSH_ERROR_EXPECTED_ARRAY, offset);
+		}
+		if (c != '{') {
+			josh_stream_fail(stream, josh_stream_filter_paths(stream, active, 0, JOSH_KEY_TYPE_OBJECT), JOSH_ERROR_EXPECTED_OBJECT, offset);
+		}
+
+		// Like josh_extract(), the whole document starts at its first byte.
+		frame->value_start = 0;
+
+		return stream->pending & ~frame->found;
+	}
+
+	uint64_t matched = 0;
+
+	if (frame->is_object) {
+		matched = stream->key_matches;
+	}
+	else {
+		for (uint64_t bits = frame->active & stream->pending; bits; bits &= bits - 1) {
+			const struct josh_key_t *key = &stream->paths[josh_ctz64(bits)].keys[stream->depth - 1];
+
+			if (key->type != JOSH_KEY_TYPE_ARRAY) continue;
+
+			if (key->wildcard ? josh_in_slice(&stream->paths[josh_ctz64(bits)], stream->depth - 1, frame->index, 0) : key->num == frame->index) {
+				matched |= bits & -bits;
+			}
+		}
+	}
+
+	uint64_t found = 0;
+
+	for (uint64_t bits = matched; bits; bits &= bits - 1) {
+		if (stream->paths[josh_ctz64(bits)].key_count == stream->depth) found |= bits & -bits;
+	}
+
+	frame->found = found;
+	frame->value_start = offset;
+
+	return matched & ~found;
+}
+
+static void josh_stream_end_value(struct josh_stream_t *stream, size_t end) {
+	// Finish the current value, which ends just before `end`, extracting any
+	// keys which resolve to it.
+
+	struct josh_stream_frame_t *frame = &stream->stack[stream->depth];
+	const uint64_t found = frame->found & stream->pending;
+
+	if (!stream->depth) {
+		stream->state = JOSH_STREAM_STATE_END;
+		stream->document_end = end;
+
+		return;
+	}
+
+	stream->state = JOSH_STREAM_STATE_AFTER_VALUE;
+	frame->found = 0;
+
+	if (!found) return;
+
+	const size_t start = frame->value_start;
+	const char *ptr = NULL;
+
+	if (start >= stream->chunk_offset) {
+		ptr = stream->chunk + (start - stream->chunk_offset);
+	}
+	else if (josh_stream_capture(stream, start, end)) {
+		ptr = stream->capture + (start - stream->capture_start);
+	}
+
+	josh_stream_emit(stream, found, ptr, start, end - start, JOSH_ERROR_NONE);
+}
+
+static bool josh_stream_open(struct josh_stream_t *stream, uint64_t active, bool is_object, size_t offset) {
+	// Push an array or object onto the stack. Return false if nested too deep.
+
+	if (stream->depth == JOSH_CONFIG_MAX_NESTING) {
+		return josh_stream_error(stream, JOSH_ERROR_MAX_NESTING_REACHED, offset);
+	}
+
+	struct josh_stream_frame_t *frame = &stream->stack[++stream->depth];
+
+	frame->active = active;
+	frame->found = 0;
+	frame->value_start = 0;
+	frame->index = 0;
+	frame->is_object = is_object;
+
+	stream->state = is_object ? JOSH_STREAM_STATE_FIRST_KEY : JOSH_STREAM_STATE_FIRST_VALUE;
+
+	return true;
+}
+
+static void josh_stream_close(struct josh_stream_t *stream, size_t offset) {
+	// Pop the container whose closing bracket is at `offset`, failing the keys
+	// which were looking for an index or key inside of it.
+
+	struct josh_stream_frame_t *frame = &stream->stack[stream->depth];
+	const uint64_t wildcards = josh_stream_filter_paths(
+		stream,
+		frame->active & stream->pending & stream->wildcards,
+		stream->depth - 1,
+		frame->is_object ? JOSH_KEY_TYPE_OBJECT : JOSH_KEY_TYPE_ARRAY
+	);
+
+	if (wildcards) {
+		josh_stream_finish_wildcards(stream, josh_filter_finished(stream->paths, wildcards, stream->depth - 1, true, 0, 0), offset);
+	}
+
+	if (frame->active & stream->pending) {
+		josh_stream_fail(
+			stream,
+			josh_stream_filter_paths(
+				stream,
+				frame->active & stream->pending & ~stream->wildcards,
+				stream->depth - 1,
+				frame->is_object ? JOSH_KEY_TYPE_OBJECT : JOSH_KEY_TYPE_ARRAY
+			),
+			frame->is_object ? JOSH_ERROR_OBJECT_KEY_NOT_FOUND : JOSH_ERROR_ARRAY_INDEX_NOT_FOUND,
+			offset
+		);
+	}
+
+	stream->depth--;
+
+	josh_stream_end_value(stream, offset + 1);
+}
+
+static inline void josh_stream_begin_key(struct josh_stream_t *stream) {
+	// Start matching an object key against the keys at the current level.
+
+	const struct josh_stream_frame_t *frame = &stream->stack[stream->depth];
+
+	stream->state = JOSH_STREAM_STATE_STRING;
+	stream->in_key = true;
+	stream->key_len = 0;
+	stream->high_surrogate = 0;
+	stream->key_matches = josh_stream_filter_paths(
+		stream,
+		frame->active & stream->pending,
+		stream->depth - 1,
+		JOSH_KEY_TYPE_OBJECT
+	);
+
+	for (uint64_t bits = stream->key_matches; bits; bits &= bits - 1) {
+		const unsigned i = josh_ctz64(bits);
+		const struct josh_key_t *key = &stream->paths[i].keys[stream->depth - 1];
+
+		if (key->escaped) josh_key_cursor_init(&stream->key_cursors[i], key);
+	}
+}
+
+static inline void josh_stream_match_key(struct josh_stream_t *stream, char c) {
+	// Drop the keys which don't match the next (decoded) char `c` of the key.
+
+	for (uint64_t bits = stream->key_matches; bits; bits &= bits - 1) {
+		const unsigned i = josh_ctz64(bits);
+		const struct josh_key_t *key = &stream->paths[i].keys[stream->depth - 1];
+
+		if (key->wildcard) continue;
+
+		if (
+			key->num <= stream->key_len ||
+			(key->escaped ? josh_key_cursor_next(&stream->key_cursors[i]) : key->str[stream->key_len]) != c
+		) {
+			stream->key_matches &= ~(bits & -bits);
+		}
+	}
+
+	stream->key_len++;
+}
+
+static void josh_stream_match_codepoint(struct josh_stream_t *stream, unsigned codepoint) {
+	// Match the UTF-8 encoding of `codepoint` against the key.
+
+	char utf8[4];
+	const char *end = josh_encode_utf8(utf8, codepoint);
+
+	for (const char *c = utf8; c < end; c++) josh_stream_match_key(stream, *c);
+}
+
+static void josh_stream_flush_surrogate(struct josh_stream_t *stream) {
+	// A high surrogate which isn't followed by a low one is decoded as U+FFFD.
+
+	if (!stream->high_surrogate) return;
+
+	stream->high_surrogate = 0;
+	josh_stream_match_codepoint(stream, 0xfffd);
+}
+
+static void josh_stream_match_unit(struct josh_stream_t *stream, unsigned unit) {
+	// Match a UTF-16 code unit from a \u escape against the key, pairing up
+	// surrogates.
+
+	if (stream->high_surrogate && unit >= 0xdc00 && unit <= 0xdfff) {
+		const unsigned high = stream->high_surrogate;
+
+		stream->high_surrogate = 0;
+		josh_stream_match_codepoint(stream, 0x10000 + ((high - 0xd800) << 10) + (unit - 0xdc00));
+
+		return;
+	}
+
+	josh_stream_flush_surrogate(stream);
+
+	if (unit >= 0xd800 && unit <= 0xdbff) stream->high_surrogate = unit;
+	else josh_stream_match_codepoint(stream, unit >= 0xdc00 && unit <= 0xdfff ? 0xfffd : unit);
+}
+
+static bool josh_stream_value(struct josh_stream_t *stream, char c, size_t offset) {
+	// Start parsing the value whose first char is `c`. Return false on error.
+
+	const uint64_t active = josh_stream_begin_value(stream, offset, c);
+
+	if (c == '\"') {
+		stream->state = JOSH_STREAM_STATE_STRING;
+		stream->in_key = false;
+	}
+	else if (c == '[' || c == '{') {
+		return josh_stream_open(stream, active, c == '{', offset);
+	}
+	else if (isdigit(c) || c == '-') {
+		stream->state = JOSH_STREAM_STATE_NUMBER;
+		stream->step = c == '-' ? JOSH_STREAM_NUMBER_MINUS :
+			c == '0' ? JOSH_STREAM_NUMBER_ZERO :
+			JOSH_STREAM_NUMBER_INT;
+	}
+	else if (c == 't' || c == 'f' || c == 'n') {
+		stream->state = JOSH_STREAM_STATE_LITERAL;
+		stream->step = 1;
+		stream->literal = c == 't' ? "true" : c == 'f' ? "false" : "null";
+		stream->literal_error = c == 't' ? JOSH_ERROR_EXPECTED_TRUE :
+			c == 'f' ? JOSH_ERROR_EXPECTED_FALSE :
+			JOSH_ERROR_EXPECTED_NULL;
+	}
+	else {
+		return josh_stream_error(stream, JOSH_ERROR_EXPECTED_LITERAL, offset);
+	}
+
+	return true;
+}
+
+static inline bool josh_stream_number(struct josh_stream_t *stream, char c, size_t offset) {
+	// Advance the number grammar by `c`. Return false if `c` isn't part of the
+	// number, in which case the number ends (or errors) before it.
+
+	const bool digit = c >= '0' && c <= '9';
+
+	switch (stream->step) {
+		case JOSH_STREAM_NUMBER_MINUS:
+			if (!digit) break;
+
+			stream->step = c == '0' ? JOSH_STREAM_NUMBER_ZERO : JOSH_STREAM_NUMBER_INT;
+
+			return true;
+		case JOSH_STREAM_NUMBER_ZERO:
+			if (digit) {
+				josh_stream_error(stream, JOSH_ERROR_NO_LEADING_ZERO, offset);
+
+				return false;
+			}
+			// fallthrough
+		case JOSH_STREAM_NUMBER_INT:
+			if (digit) return true;
+
+			if (c == '.') {
+				stream->step = JOSH_STREAM_NUMBER_DOT;
+
+				return true;
+			}
+			// fallthrough
+		case JOSH_STREAM_NUMBER_FRACTION:
+			if (digit) return true;
+
+			if (c == 'e' || c == 'E') {
+				stream->step = JOSH_STREAM_NUMBER_E;
+
+				return true;
+			}
+
+			break;
+		case JOSH_STREAM_NUMBER_DOT:
+			if (!digit) break;
+
+			stream->step = JOSH_STREAM_NUMBER_FRACTION;
+
+			return true;
+		case JOSH_STREAM_NUMBER_E:
+			if (c == '-' || c == '+') {
+				stream->step = JOSH_STREAM_NUMBER_EXPONENT_SIGN;
+
+				return true;
+			}
+			// fallthrough
+		case JOSH_STREAM_NUMBER_EXPONENT_SIGN:
+			if (!digit) break;
+
+			stream->step = JOSH_STREAM_NUMBER_EXPONENT;
+
+			return true;
+		case JOSH_STREAM_NUMBER_EXPONENT:
+			if (digit) return true;
+
+			break;
+		default:
+			break;
+	}
+
+	// The number has ended, which is only valid if its last part had digits
+	// and it is followed by a value terminator.
+	if (
+		stream->step == JOSH_STREAM_NUMBER_MINUS ||
+		stream->step == JOSH_STREAM_NUMBER_DOT ||
+		stream->step == JOSH_STREAM_NUMBER_E ||
+		stream->step == JOSH_STREAM_NUMBER_EXPONENT_SIGN ||
+		!josh_is_value_terminator(c)
+	) {
+		josh_stream_error(stream, JOSH_ERROR_DIGIT_EXPECTED, offset);
+
+		return false;
+	}
+
+	josh_stream_end_value(stream, offset);
+
+	return false;
+}
+
+bool josh_stream_feed(struct josh_stream_t *stream, const char *chunk, size_t len) {
+	// Parse the next `len` bytes of the document. Results are emitted as soon
+	// as they are known, and the chunk can be discarded once this returns.
+	// Return false on error, with `error_id` and `offset` set on the stream.
+	// Once `done` is set, the rest of the document doesn't need to be fed.
+
+	if (stream->state == JOSH_STREAM_STATE_ERROR) return false;
+	if (stream->done) return true;
+
+	stream->chunk = chunk;
+	stream->chunk_offset = stream->offset;
+
+	size_t i = 0;
+
+	while (i < len && !stream->done) {
+		const char c = chunk[i];
+		const size_t offset = stream->chunk_offset + i;
+
+		switch (stream->state) {
+			case JOSH_STREAM_STATE_VALUE:
+				if (josh_is_whitespace(c)) break;
+				if (!josh_stream_value(stream, c, offset)) return false;
+
+				break;
+			case JOSH_STREAM_STATE_FIRST_VALUE:
+			case JOSH_STREAM_STATE_NEXT_VALUE:
+				if (josh_is_whitespace(c)) break;
+
+				if (c == ']') {
+					if (stream->state == JOSH_STREAM_STATE_NEXT_VALUE && !JOSH_CONFIG_ALLOW_TRAILING_COMMA) {
+						return josh_stream_error(stream, JOSH_ERROR_NO_TRAILING_COMMA, offset);
+					}
+
+					josh_stream_close(stream, offset);
+
+					break;
+				}
+
+				if (!josh_stream_value(stream, c, offset)) return false;
+
+				break;
+			case JOSH_STREAM_STATE_FIRST_KEY:
+			case JOSH_STREAM_STATE_NEXT_KEY:
+				if (josh_is_whitespace(c)) break;
+
+				if (c == '}') {
+					if (stream->state == JOSH_STREAM_STATE_NEXT_KEY && !JOSH_CONFIG_ALLOW_TRAILING_COMMA) {
+						return josh_stream_error(stream, JOSH_ERROR_NO_TRAILING_COMMA, offset);
+					}
+
+					josh_stream_close(stream, offset);
+
+					break;
+				}
+
+				if (c != '\"') return josh_stream_error(stream, JOSH_ERROR_EXPECTED_STRING, offset);
+
+				josh_stream_begin_key(stream);
+
+				break;
+			case JOSH_STREAM_STATE_COLON:
+				if (josh_is_whitespace(c)) break;
+				if (c != ':') return josh_stream_error(stream, JOSH_ERROR_EXPECTED_COLON, offset);
+
+				stream->state = JOSH_STREAM_STATE_VALUE;
+
+				break;
+			case JOSH_STREAM_STATE_AFTER_VALUE: {
+				if (josh_is_whitespace(c)) break;
+
+				struct josh_stream_frame_t *frame = &stream->stack[stream->depth];
+
+				if (c == ',') {
+					const uint64_t wildcards = frame->active & stream->pending & stream->wildcards;
+
+					frame->index++;
+
+					if (wildcards) {
+						josh_stream_finish_wildcards(stream, josh_filter_finished(stream->paths, wildcards, stream->depth - 1, false, frame->index, 0), offset);
+					}
+
+					stream->state = frame->is_object ? JOSH_STREAM_STATE_NEXT_KEY : JOSH_STREAM_STATE_NEXT_VALUE;
+				}
+				else if (c == (frame->is_object ? '}' : ']')) {
+					josh_stream_close(stream, offset);
+				}
+				else {
+					return josh_stream_error(stream, JOSH_ERROR_UNEXPECTED_CHAR, offset);
+				}
+
+				break;
+			}
+			case JOSH_STREAM_STATE_STRING:
+				// Skip over the plain chars in one go, unless they need to be
+				// matched against the keys being extracted.
+				if (!stream->key_matches || !stream->in_key) {
+					while (i < len && chunk[i] != '\"' && chunk[i] != '\\' && chunk[i]) i++;
+
+					if (i == len) continue;
+				}
+
+				// Like josh_iter_string(), a NUL char ends the string early.
+				if (!chunk[i]) {
+					return josh_stream_error(stream, JOSH_ERROR_STRING_NOT_CLOSED, stream->chunk_offset + i);
+				}
+
+				if (chunk[i] == '\"') {
+					if (stream->in_key) {
+						josh_stream_flush_surrogate(stream);
+
+						// Only keys which were matched in full are left.
+						for (uint64_t bits = stream->key_matches; bits; bits &= bits - 1) {
+							const struct josh_key_t *key = &stream->paths[josh_ctz64(bits)].keys[stream->depth - 1];
+
+							if (!key->wildcard && key->num != stream->key_len) {
+								stream->key_matches &= ~(bits & -bits);
+							}
+						}
+
+						stream->state = JOSH_STREAM_STATE_COLON;
+					}
+					else {
+						josh_stream_end_value(stream, stream->chunk_offset + i + 1);
+					}
+				}
+				else if (chunk[i] == '\\') {
+					stream->state = JOSH_STREAM_STATE_STRING_ESCAPE;
+				}
+				else {
+					josh_stream_flush_surrogate(stream);
+					josh_stream_match_key(stream, chunk[i]);
+				}
+
+				break;
+			case JOSH_STREAM_STATE_STRING_ESCAPE:
+				if (c == 'u') {
+					stream->state = JOSH_STREAM_STATE_STRING_UNICODE;
+					stream->step = 4;
+					stream->code = 0;
+
+					break;
+				}
+				else if (
+					c == '\"' ||
+					c == '\\' ||
+					c == '/' ||
+					c == 'b' ||
+					c == 'f' ||
+					c == 'n' ||
+					c == 't' ||
+					c == 'r'
+				) {
+					stream->state = JOSH_STREAM_STATE_STRING;
+				}
+				else {
+					return josh_stream_error(stream, JOSH_ERROR_INVALID_ESCAPE_CODE, offset);
+				}
+
+				if (stream->in_key) {
+					josh_stream_flush_surrogate(stream);
+					josh_stream_match_key(stream,
+						c == 'b' ? '\b' :
+						c == 'f' ? '\f' :
+						c == 'n' ? '\n' :
+						c == 'r' ? '\r' :
+						c == 't' ? '\t' :
+						c
+					);
+				}
+
+				break;
+			case JOSH_STREAM_STATE_STRING_UNICODE:
+				if (!isxdigit(c)) return josh_stream_error(stream, JOSH_ERROR_INVALID_UNICODE_ESCAPE_CODE, offset);
+
+				stream->code = (stream->code << 4) | josh_hex_value(c);
+
+				if (!--stream->step) {
+					stream->state = JOSH_STREAM_STATE_STRING;
+					if (stream->in_key) josh_stream_match_unit(stream, stream->code);
+				}
+
+				break;
+			case JOSH_STREAM_STATE_NUMBER:
+				if (josh_stream_number(stream, c, offset)) break;
+				if (stream->state == JOSH_STREAM_STATE_ERROR) return false;
+
+				// The char after the number still needs to be parsed.
+				continue;
+			case JOSH_STREAM_STATE_LITERAL:
+				if (c != stream->literal[stream->step]) {
+					return josh_stream_error(stream, stream->literal_error, offset);
+				}
+
+				if (!stream->literal[++stream->step]) josh_stream_end_value(stream, offset + 1);
+
+				break;
+			case JOSH_STREAM_STATE_END:
+				if (!josh_is_whitespace(c)) return josh_stream_error(stream, JOSH_ERROR_UNEXPECTED_CHAR, offset);
+
+				break;
+			default:
+				return false;
+		}
+
+		i++;
+	}
+
+	stream->offset = stream->chunk_offset + len;
+
+	// Keep a copy of any values which are still being extracted, starting from
+	// the outermost one, since the chunk is about to go away.
+	bool capturing = false;
+
+	for (unsigned depth = 0; depth <= stream->depth; depth++) {
+		const struct josh_stream_frame_t *frame = &stream->stack[depth];
+
+		if (frame->found & stream->pending) {
+			josh_stream_capture(stream, frame->value_start, stream->offset);
+			capturing = true;
+
+			break;
+		}
+	}
+
+	// Results can point into the capture, so the next value gets a capture of
+	// its own rather than copying over this one. Any unused room is given back.
+	if (!capturing && stream->capture_len) {
+		josh_arena_realloc(stream->arena, stream->capture, stream->capture_capacity, stream->capture_len, 1);
+
+		stream->capture = NULL;
+		stream->capture_len = 0;
+		stream->capture_capacity = 0;
+	}
+
+	stream->chunk = NULL;
+
+	return true;
+}
+
+bool josh_stream_finish(struct josh_stream_t *stream) {
+	// Signal the end of the document, completing a trailing number and failing
+	// any keys which weren't found. Return true if all keys were found.
+
+	if (stream->state != JOSH_STREAM_STATE_ERROR && !stream->done) {
+		stream->chunk = NULL;
+		stream->chunk_offset = stream->offset;
+
+		if (stream->state == JOSH_STREAM_STATE_NUMBER) {
+			josh_stream_number(stream, '\0', stream->offset);
+		}
+
+		switch (stream->state) {
+			case JOSH_STREAM_STATE_END: {
+				const uint64_t found = stream->stack[0].found & stream->pending;
+				const char *ptr = josh_stream_capture(stream, 0, stream->document_end) ? stream->capture : NULL;
+
+				josh_stream_emit(stream, found, ptr, 0, stream->document_end, JOSH_ERROR_NONE);
+
+				josh_stream_finish_wildcards(stream, stream->pending & stream->wildcards, stream->document_end);
+
+				break;
+			}
+			case JOSH_STREAM_STATE_ERROR:
+				break;
+			case JOSH_STREAM_STATE_STRING:
+			case JOSH_STREAM_STATE_STRING_ESCAPE:
+			case JOSH_STREAM_STATE_STRING_UNICODE:
+				josh_stream_error(stream, JOSH_ERROR_STRING_NOT_CLOSED, stream->offset);
+
+				break;
+			case JOSH_STREAM_STATE_LITERAL:
+				josh_stream_error(stream, stream->literal_error, stream->offset);
+
+				break;
+			case JOSH_STREAM_STATE_VALUE:
+				if (!stream->depth) {
+					josh_stream_error(stream, JOSH_ERROR_EMPTY_VALUE, stream->offset);
+
+					break;
+				}
+				// fallthrough
+			case JOSH_STREAM_STATE_FIRST_VALUE:
+			case JOSH_STREAM_STATE_NEXT_VALUE:
+				josh_stream_error(stream, JOSH_ERROR_EXPECTED_LITERAL, stream->offset);
+
+				break;
+			case JOSH_STREAM_STATE_FIRST_KEY:
+			case JOSH_STREAM_STATE_NEXT_KEY:
+				josh_stream_error(stream, JOSH_ERROR_EXPECTED_STRING, stream->offset);
+
+				break;
+			case JOSH_STREAM_STATE_COLON:
+				josh_stream_error(stream, JOSH_ERROR_EXPECTED_COLON, stream->offset);
+
+				break;
+			default:
+				josh_stream_error(stream, JOSH_ERROR_UNEXPECTED_CHAR, stream->offset);
+
+				break;
+		}
+	}
+
+	for (unsigned i = 0; i < stream->path_count; i++) {
+		if (stream->results[i].error_id) return false;
+	}
+
+	return !stream->pending;
 }
@@ -1,4 +1,7 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
+#include <unistd.h>
 
 #include "josh.h"
 
@@ -22,9 +25,37 @@
 	} \
 }
 
-static struct josh_ctx_t ctx;
+static uint8_t buffer[JOSH_CONFIG_MAX_MEMORY];
+static struct josh_arena_t arena;
+static struct josh_ctx_t ctx = { .arena = &arena };
+
+static unsigned alloc_count;
+
+static void *counting_alloc(void *user, size_t bytes) {
+	(void)user;
+	alloc_count++;
+
+	return malloc(bytes);
+}
+
+static unsigned stream_emitted;
+static char stream_value[64];
+
+static void stream_callback(void *user, unsigned index, const struct josh_result_t *result) {
+	(void)user;
+	(void)index;
+	stream_emitted++;
+
+	if (result->ptr && result->len < sizeof(stream_value)) {
+		memcpy(stream_value, result->ptr, result->len);
+		stream_value[result->len] = '\0';
+	}
+}
 
 int main(void) {
+	josh_arena_init(&arena, buffer, sizeof(buffer));
+	arena.alloc = NULL;
+
 	TEST("simple array access") {
 		const char *json = "[1]";
 
@@ -283,6 +314,32 @@ int main(void) {
 		ASSERT(ctx.offset == 7);
 	}
 
+	TEST("parse long strings spanning multiple blocks") {
+		const char *json = "[\"abcdefghijklmnopqrstuvwxyz0123456789abcdefghijklmnopqrstuvwxyz\\\"0123456789\", 1]";
+
+		const char *out = josh_extract(&ctx, json, "[1]");
+
+		ASSERT(!ctx.error_id);
+		ASSERT(out == json + 79);
+		ASSERT(ctx.len == 1);
+
+		out = josh_extract(&ctx, json, "[0]");
+
+		ASSERT(out == json + 1);
+		ASSERT(ctx.len == 76);
+	}
+
+	TEST("set error when long string is never closed") {
+		const char *json = "[\"abcdefghijklmnopqrstuvwxyz0123456789abcdefghijklmnopqrstuvwxyz";
+
+		const char *out = josh_extract(&ctx, json, "[0]");
+
+		ASSERT(!out);
+		ASSERT(ctx.error_id == JOSH_ERROR_STRING_NOT_CLOSED);
+		ASSERT(ctx.column == 65);
+		ASSERT(ctx.offset == 64);
+	}
+
 	TEST("set error for invalid object key") {
 		const char *json = "";
 
@@ -418,6 +475,75 @@ int main(void) {
 		ASSERT(ctx.offset == 4);
 	}
 
+	TEST("skip long runs of whitespace") {
+		const char *json = "{\n    \"a\": [\n        1,\n\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t2\n    ]\n}";
+
+		const char *out = josh_extract(&ctx, json, ".a[1]");
+
+		ASSERT(!ctx.error_id);
+		ASSERT(out == json + 58);
+		ASSERT(ctx.len == 1);
+	}
+
+	TEST("set line and column after long runs of whitespace") {
+		const char *json = "[\n\n                                        \n\r\n  x]";
+
+		const char *out = josh_extract(&ctx, json, "[0]");
+
+		ASSERT(!out);
+		ASSERT(ctx.error_id == JOSH_ERROR_EXPECTED_LITERAL);
+		ASSERT(ctx.line == 5);
+		ASSERT(ctx.column == 3);
+		ASSERT(ctx.offset == 48);
+
+		json = "[1,                                                       x]";
+		out = josh_extract(&ctx, json, "");
+
+		ASSERT(!out);
+		ASSERT(ctx.line == 1);
+		ASSERT(ctx.column == 59);
+		ASSERT(ctx.offset == 58);
+	}
+
+	TEST("get line and column of error") {
+		const char *json = "{\n  \"a\": [\n    1,\n    2\n  ]\n}";
+
+		const char *out = josh_extract(&ctx, json, ".a[2]");
+
+		ASSERT(!out);
+		ASSERT(ctx.error_id == JOSH_ERROR_ARRAY_INDEX_NOT_FOUND);
+		ASSERT(ctx.line == 5);
+		ASSERT(ctx.column == 3);
+
+		unsigned line = 0;
+		unsigned column = 0;
+
+		josh_error_position(&ctx, &line, &column);
+
+		ASSERT(line == 5);
+		ASSERT(column == 3);
+	}
+
+	TEST("key errors don't read the last JSON") {
+		char *json = malloc(32);
+		struct josh_path_t path;
+
+		ASSERT(json);
+		strcpy(json, "{\n\n\"a\": 1}");
+		ASSERT(!josh_extract(&ctx, json, ".b"));
+		free(json);
+
+		ASSERT(!josh_compile_key(&ctx, &path, ".a[1x]"));
+		ASSERT(ctx.error_id == JOSH_ERROR_KEY_NUMBER_INVALID);
+
+		unsigned line = 0;
+		unsigned column = 0;
+
+		josh_error_position(&ctx, &line, &column);
+
+		ASSERT(line == 1);
+	}
+
 	TEST("parse string in array as dictionary key") {
 		const char *json = "{\"abc\": 123}";
 
@@ -534,17 +660,18 @@ int main(void) {
 
 	TEST("allocate memory increments counter") {
 		josh_reset(&ctx);
+		josh_arena_reset(&arena);
 
 		void *memory = josh_malloc(&ctx, 1);
 
 		ASSERT(memory);
-		ASSERT(ctx.allocated == 1);
+		ASSERT(arena.allocated == 1);
 
 		void *memory2 = josh_malloc(&ctx, 2);
 
 		ASSERT(memory2);
 		ASSERT(memory2 == memory + 1);
-		ASSERT(ctx.allocated == 3);
+		ASSERT(arena.allocated == 3);
 	}
 
 	TEST("set error if allocating more them max memory") {
@@ -556,6 +683,269 @@ int main(void) {
 		ASSERT(ctx.error_id == JOSH_ERROR_OUT_OF_MEMORY);
 	}
 
+	TEST("arena grows by allocating new blocks") {
+		struct josh_arena_t growing;
+		josh_arena_init(&growing, NULL, 0);
+		growing.alloc = counting_alloc;
+		growing.block_size = 64;
+		alloc_count = 0;
+
+		uint8_t *a = josh_arena_alloc(&growing, 48, 1);
+		uint8_t *b = josh_arena_alloc(&growing, 48, 1);
+		uint8_t *c = josh_arena_alloc(&growing, 1000, 16);
+
+		ASSERT(a && b && c);
+		ASSERT(alloc_count == 3);
+		ASSERT(((uintptr_t)c & 15) == 0);
+		ASSERT(growing.allocated == 1096);
+		ASSERT(growing.high_water == 1096);
+
+		josh_arena_reset(&growing);
+
+		ASSERT(!growing.allocated);
+		ASSERT(growing.high_water == 1096);
+
+		uint8_t *d = josh_arena_alloc(&growing, 48, 1);
+		uint8_t *e = josh_arena_alloc(&growing, 48, 1);
+
+		ASSERT(d == a);
+		ASSERT(e == b);
+		ASSERT(alloc_count == 3);
+
+		josh_arena_free(&growing);
+
+		ASSERT(!growing.head);
+	}
+
+	TEST("arena can use initial buffer and limit") {
+		static uint8_t small[256];
+		struct josh_arena_t limited;
+		josh_arena_init(&limited, small, sizeof(small));
+		limited.alloc = counting_alloc;
+		limited.limit = 1024;
+		alloc_count = 0;
+
+		uint8_t *a = josh_arena_alloc(&limited, 100, 1);
+
+		ASSERT(a >= small && a < small + sizeof(small));
+		ASSERT(!alloc_count);
+
+		ASSERT(josh_arena_alloc(&limited, 500, 1));
+		ASSERT(alloc_count == 1);
+		ASSERT(!josh_arena_alloc(&limited, 500, 1));
+
+		josh_arena_free(&limited);
+
+		ASSERT(limited.head);
+		ASSERT(josh_arena_alloc(&limited, 100, 1) == a);
+	}
+
+	TEST("parse big JSON into growable arena") {
+		struct josh_arena_t growing;
+		josh_arena_init(&growing, NULL, 0);
+		growing.block_size = 128;
+
+		struct josh_ctx_t parse_ctx = { .arena = &growing };
+
+		char json[256] = "[0";
+
+		for (unsigned i = 1; i < 40; i++) {
+			sprintf(json + strlen(json), ",%u", i);
+		}
+		strcat(json, "]");
+
+		struct josh_node_t *root = josh_parse(&parse_ctx, json);
+
+		ASSERT(root);
+		ASSERT(josh_is_array(root));
+		ASSERT(parse_ctx.node_count == 41);
+		ASSERT(growing.high_water >= 41 * sizeof(struct josh_node_t));
+
+		for (unsigned i = 0; i < 40; i++) {
+			ASSERT(josh_int_value(josh_array_get(root, i)) == i);
+		}
+
+		josh_arena_free(&growing);
+	}
+
+	TEST("moved allocations still count towards the arena limit") {
+		struct josh_arena_t growing;
+		josh_arena_init(&growing, NULL, 0);
+		growing.block_size = 64;
+		growing.limit = 256;
+
+		uint8_t *a = josh_arena_alloc(&growing, 64, 1);
+		uint8_t *b = josh_arena_realloc(&growing, a, 64, 128, 1);
+
+		// The old copy stays in the first block until the next reset.
+		ASSERT(a && b && b != a);
+		ASSERT(growing.allocated == 192);
+		ASSERT(!josh_arena_realloc(&growing, b, 128, 256, 1));
+		ASSERT(growing.allocated == 192);
+
+		// Shrinking the latest allocation gives the rest back.
+		ASSERT(josh_arena_realloc(&growing, b, 128, 32, 1) == b);
+		ASSERT(growing.allocated == 96);
+		ASSERT(growing.high_water == 192);
+
+		josh_arena_free(&growing);
+	}
+
+	TEST("small parse stays inside the caller's buffer") {
+		static uint8_t caller_buffer[1024 * 64];
+		static char json[1024 * 10];
+		struct josh_arena_t buffered;
+		josh_arena_init(&buffered, caller_buffer, sizeof(caller_buffer));
+		buffered.alloc = counting_alloc;
+		alloc_count = 0;
+
+		struct josh_ctx_t parse_ctx = { .arena = &buffered };
+
+		memset(json, ' ', sizeof(json) - 1);
+		json[0] = '[';
+		json[sizeof(json) - 3] = '1';
+		json[sizeof(json) - 2] = ']';
+
+		struct josh_node_t *root = josh_parse(&parse_ctx, json);
+
+		ASSERT(root);
+		ASSERT((uint8_t *)root >= caller_buffer && (uint8_t *)root < caller_buffer + sizeof(caller_buffer));
+		ASSERT(parse_ctx.node_count == 2);
+		ASSERT(!alloc_count);
+		ASSERT(buffered.allocated == 2 * sizeof(struct josh_node_t));
+		ASSERT(buffered.high_water <= 16 * sizeof(struct josh_node_t));
+	}
+
+	TEST("arena high water tracks nodes rather than document size") {
+		const size_t len = 1024 * 1024 * 3;
+		char *json = malloc(len + 1);
+		struct josh_arena_t growing;
+		josh_arena_init(&growing, NULL, 0);
+
+		struct josh_ctx_t parse_ctx = { .arena = &growing };
+
+		ASSERT(json);
+
+		// A single string.
+		memset(json, 'x', len);
+		json[0] = json[len - 1] = '"';
+		json[len] = '\0';
+
+		ASSERT(josh_parse(&parse_ctx, json));
+		ASSERT(parse_ctx.node_count == 1);
+		ASSERT(growing.high_water <= 16 * sizeof(struct josh_node_t));
+
+		// Mostly whitespace, with room left in the limit for other allocations.
+		memset(json, ' ', len);
+		memcpy(json + len - 5, "[1.5]", 5);
+
+		ASSERT(josh_parse(&parse_ctx, json));
+		ASSERT(parse_ctx.node_count == 2);
+		ASSERT(growing.high_water <= 16 * sizeof(struct josh_node_t));
+		ASSERT(josh_malloc(&parse_ctx, JOSH_CONFIG_MAX_MEMORY / 2));
+
+		josh_arena_free(&growing);
+		free(json);
+	}
+
+	TEST("big tapes grow by doubling") {
+		const size_t count = 300000;
+		char *json = malloc(count * 2 + 2);
+		struct josh_arena_t growing;
+		josh_arena_init(&growing, NULL, 0);
+		growing.limit = 0;
+
+		struct josh_ctx_t parse_ctx = { .arena = &growing };
+
+		ASSERT(json);
+
+		for (size_t i = 0; i < count; i++) {
+			json[i * 2] = i ? ',' : '[';
+			json[i * 2 + 1] = '1';
+		}
+		strcpy(json + count * 2, "]");
+
+		struct josh_node_t *root = josh_parse(&parse_ctx, json);
+
+		// The copies left behind add up to less than the final tape, which is
+		// less than twice the nodes.
+		ASSERT(root);
+		ASSERT(josh_array_size(root) == count);
+		ASSERT(parse_ctx.node_capacity == count + 1);
+		ASSERT(growing.high_water < 4 * (count + 1) * sizeof(struct josh_node_t));
+
+		josh_arena_free(&growing);
+		free(json);
+	}
+
+	TEST("16 byte nodes fit twice as many in the arena limit") {
+		// 32 byte nodes could only hold half this many within the limit. The
+		// tape grows in place within a single buffer the size of the limit.
+		const size_t count = JOSH_CONFIG_MAX_MEMORY / 32 * 2;
+		char *json = malloc(count * 2 + 2);
+		void *tape_buffer = malloc(JOSH_ARENA_HEADER_SIZE + JOSH_CONFIG_MAX_MEMORY);
+		struct josh_arena_t limited;
+		josh_arena_init(&limited, tape_buffer, JOSH_ARENA_HEADER_SIZE + JOSH_CONFIG_MAX_MEMORY);
+		limited.alloc = NULL;
+
+		struct josh_ctx_t parse_ctx = { .arena = &limited };
+
+		ASSERT(json && tape_buffer);
+
+		for (size_t i = 0; i < count; i++) {
+			json[i * 2] = i ? ',' : '[';
+			json[i * 2 + 1] = '1';
+		}
+
+		// The array and all but one of the elements fill the tape exactly.
+		json[count * 2 - 2] = ']';
+		json[count * 2 - 1] = '\0';
+
+		ASSERT(josh_parse(&parse_ctx, json));
+		ASSERT(parse_ctx.node_count == count);
+		ASSERT(parse_ctx.node_count * sizeof(struct josh_node_t) == JOSH_CONFIG_MAX_MEMORY);
+
+		json[count * 2 - 2] = ',';
+		json[count * 2 - 1] = '1';
+		strcpy(json + count * 2, "]");
+
+		ASSERT(!josh_parse(&parse_ctx, json));
+		ASSERT(parse_ctx.error_id == JOSH_ERROR_OUT_OF_MEMORY);
+
+		free(json);
+		free(tape_buffer);
+	}
+
+	TEST("reset only clears scanning state") {
+		josh_extract(&ctx, "[1]", "[5]");
+
+		ASSERT(ctx.error_id);
+
+		josh_reset(&ctx);
+
+		ASSERT(!ctx.error_id);
+		ASSERT(ctx.line == 1);
+		ASSERT(ctx.column == 1);
+		ASSERT(ctx.arena == &arena);
+	}
+
+	TEST("extraction context does not need an arena") {
+		struct josh_ctx_t small = { 0 };
+
+		ASSERT(sizeof(small) < 1024);
+
+		const char *json = "{\"a\": [1, 2]}";
+		const char *out = josh_extract(&small, json, ".a[1]");
+
+		ASSERT(out == json + 10);
+		ASSERT(small.len == 1);
+
+		const struct josh_node_t *root = josh_parse(&small, json);
+
+		ASSERT(!root);
+		ASSERT(small.error_id == JOSH_ERROR_OUT_OF_MEMORY);
+	}
+
 	TEST("string keys are properly compared") {
 		const char *json = "{\"a\": 1}";
 
@@ -672,111 +1062,1615 @@ int main(void) {
 		ASSERT(ctx.offset == 8);
 	}
 
-	TEST("parse null node") {
-		const char *json = "null";
-
-		struct josh_node_t *root = josh_parse(&ctx, json);
+	TEST("skip nested values which are not part of key") {
+		const char *json = "{\"a\": {\"b\": [1, 2]}, \"c\": [[3], [4]]}";
 
-		ASSERT(root);
-		ASSERT(root->type == JOSH_NODE_TYPE_NULL);
+		const char *out = josh_extract(&ctx, json, ".c[1][0]");
 
-		ASSERT(josh_is_null(root));
+		ASSERT(!ctx.error_id);
+		ASSERT(ctx.len == 1);
+		ASSERT(out == json + 33);
 	}
 
-	TEST("parse true node") {
-		const char *json = "true";
+	TEST("whitespace is allowed after values") {
+		const char *json = "{\n  \"a\": 1 ,\n  \"b\": [2 ]\n}";
 
-		struct josh_node_t *root = josh_parse(&ctx, json);
+		const char *out = josh_extract(&ctx, json, ".b[0]");
 
-		ASSERT(root);
-		ASSERT(root->type == JOSH_NODE_TYPE_TRUE);
+		ASSERT(!ctx.error_id);
+		ASSERT(ctx.len == 1);
+		ASSERT(out == json + 21);
+	}
 
-		ASSERT(josh_is_true(root));
-		ASSERT(!josh_is_false(root));
-		ASSERT(josh_is_bool(root));
+	TEST("set error for missing comma between values") {
+		const char *json = "[\"a\" \"b\"]";
+
+		const char *out = josh_extract(&ctx, json, "[1]");
+
+		ASSERT(!out);
+		ASSERT(!ctx.len);
+		ASSERT(ctx.error_id == JOSH_ERROR_UNEXPECTED_CHAR);
+		ASSERT(ctx.offset == 5);
 	}
 
-	TEST("parse false node") {
-		const char *json = "false";
+	TEST("extract many keys at once") {
+		const char *json = "{\"a\": 1, \"b\": [true, {\"c\": null}], \"d\": \"e\"}";
+		const char *keys[] = { ".d", ".b[1].c", ".a", ".b" };
+		struct josh_result_t results[4];
 
-		struct josh_node_t *root = josh_parse(&ctx, json);
+		const bool ok = josh_extract_many(&ctx, json, keys, results, 4);
 
-		ASSERT(root);
-		ASSERT(root->type == JOSH_NODE_TYPE_FALSE);
+		ASSERT(ok);
+		ASSERT(results[0].ptr == json + 40);
+		ASSERT(results[0].len == 3);
+		ASSERT(results[1].ptr == json + 27);
+		ASSERT(results[1].len == 4);
+		ASSERT(results[2].ptr == json + 6);
+		ASSERT(results[2].len == 1);
+		ASSERT(results[3].ptr == json + 14);
+		ASSERT(results[3].len == 19);
+	}
 
-		ASSERT(josh_is_false(root));
-		ASSERT(!josh_is_true(root));
-		ASSERT(josh_is_bool(root));
+	TEST("extract many stops once all keys are found") {
+		const char *json = "[1, 2, x]";
+		const char *keys[] = { "[1]", "[0]" };
+		struct josh_result_t results[2];
+
+		const bool ok = josh_extract_many(&ctx, json, keys, results, 2);
+
+		ASSERT(ok);
+		ASSERT(!ctx.error_id);
+		ASSERT(results[0].ptr == json + 4);
+		ASSERT(results[1].ptr == json + 1);
 	}
 
-	TEST("parse int node") {
-		const char *json = "123";
+	TEST("extract many sets error per key") {
+		const char *json = "{\"a\": [1], \"b\": 2}";
+		const char *keys[] = { ".a[5]", ".b", ".c", "" };
+		struct josh_result_t results[4];
 
-		struct josh_node_t *root = josh_parse(&ctx, json);
+		const bool ok = josh_extract_many(&ctx, json, keys, results, 4);
 
-		ASSERT(root);
-		ASSERT(root->type == JOSH_NODE_TYPE_INT);
+		ASSERT(!ok);
+		ASSERT(!results[0].ptr);
+		ASSERT(results[0].error_id == JOSH_ERROR_ARRAY_INDEX_NOT_FOUND);
+		ASSERT(results[0].offset == 8);
+		ASSERT(results[1].ptr == json + 16);
+		ASSERT(results[1].len == 1);
+		ASSERT(!results[1].error_id);
+		ASSERT(!results[2].ptr);
+		ASSERT(results[2].error_id == JOSH_ERROR_OBJECT_KEY_NOT_FOUND);
+		ASSERT(results[2].offset == 17);
+		ASSERT(results[3].ptr == json);
+		ASSERT(results[3].len == 18);
+	}
+
+	TEST("extract many sets error for all keys on syntax error") {
+		const char *json = "[1, x]";
+		const char *keys[] = { "[0]", "[1]" };
+		struct josh_result_t results[2];
+
+		const bool ok = josh_extract_many(&ctx, json, keys, results, 2);
 
-		ASSERT(josh_is_int(root));
-		ASSERT(!josh_is_float(root));
-		ASSERT(josh_is_numeric(root));
-		ASSERT(josh_int_value(root) == 123);
+		ASSERT(!ok);
+		ASSERT(results[0].ptr == json + 1);
+		ASSERT(!results[0].error_id);
+		ASSERT(!results[1].ptr);
+		ASSERT(results[1].error_id == JOSH_ERROR_EXPECTED_LITERAL);
+		ASSERT(results[1].offset == 4);
 	}
 
-	TEST("parse negative int node") {
-		const char *json = "-123";
+	TEST("extract many keys past the stack buffer") {
+		const char *json = "[0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19]";
+		char key_names[20][8];
+		const char *keys[20];
+		struct josh_result_t results[20];
+		struct josh_ctx_t no_arena = { 0 };
 
-		struct josh_node_t *root = josh_parse(&ctx, json);
+		for (unsigned i = 0; i < 20; i++) {
+			sprintf(key_names[i], "[%u]", 19 - i);
+			keys[i] = key_names[i];
+		}
 
-		ASSERT(root);
-		ASSERT(root->type == JOSH_NODE_TYPE_INT);
+		// The compiled keys are taken from the arena, and given back after.
+		josh_arena_reset(&arena);
 
-		ASSERT(josh_is_int(root));
-		ASSERT(!josh_is_float(root));
-		ASSERT(josh_is_numeric(root));
-		ASSERT(josh_int_value(root) == -123);
+		ASSERT(josh_extract_many(&ctx, json, keys, results, 20));
+		ASSERT(!arena.allocated);
+		ASSERT(arena.high_water >= 20 * sizeof(struct josh_path_t));
+
+		for (unsigned i = 0; i < 20; i++) {
+			ASSERT(atoi(results[i].ptr) == (int)(19 - i));
+		}
+
+		ASSERT(josh_extract_many(&no_arena, json, keys, results, 20));
+		ASSERT(atoi(results[0].ptr) == 19);
+
+		// Keys which don't compile fail every key, as before.
+		keys[12] = "[1";
+
+		ASSERT(!josh_extract_many(&no_arena, json, keys, results, 20));
+		ASSERT(no_arena.error_id);
+		ASSERT(results[0].error_id == no_arena.error_id);
+		ASSERT(results[19].error_id == no_arena.error_id);
 	}
 
-	TEST("parse float node") {
-		const char *json = "3.1415";
+	TEST("set error if extracting too many keys") {
+		const char *keys[JOSH_MAX_PATHS + 1] = { 0 };
+		struct josh_result_t results[JOSH_MAX_PATHS + 1];
 
-		struct josh_node_t *root = josh_parse(&ctx, json);
+		const bool ok = josh_extract_many(&ctx, "[]", keys, results, JOSH_MAX_PATHS + 1);
 
-		ASSERT(root);
-		ASSERT(root->type == JOSH_NODE_TYPE_FLOAT);
+		ASSERT(!ok);
+		ASSERT(ctx.error_id == JOSH_ERROR_KEY_MAX_COUNT_REACHED);
+	}
 
-		ASSERT(josh_is_float(root));
-		ASSERT(!josh_is_int(root));
-		ASSERT(josh_is_numeric(root));
+	TEST("object keys must match exactly") {
+		const char *json = "{\"ab\": 1, \"a\": 2}";
 
-		const long double value = josh_float_value(root);
-		const long double expected = 3.1415L;
+		const char *out = josh_extract(&ctx, json, ".a");
 
-		ASSERT((expected - 0.01L) < value);
-		ASSERT(value < (expected + 0.01L));
+		ASSERT(out == json + 15);
+		ASSERT(ctx.len == 1);
 	}
 
-	TEST("parse empty array node") {
-		const char *json = "[]";
+	TEST("compile key stores length and hash of object keys") {
+		struct josh_path_t path;
+		struct josh_path_t other;
 
-		struct josh_node_t *root = josh_parse(&ctx, json);
+		const bool ok = josh_compile_key(&ctx, &path, ".abc[\"abc\"][1]");
 
-		ASSERT(root);
-		ASSERT(root->type == JOSH_NODE_TYPE_ARRAY);
+		ASSERT(ok);
+		ASSERT(josh_compile_key(&ctx, &other, ".abd"));
+		ASSERT(path.key_count == 3);
+		ASSERT(path.keys[0].type == JOSH_KEY_TYPE_OBJECT);
+		ASSERT(path.keys[0].num == 3);
+		ASSERT(strncmp(path.keys[0].str, "abc", 3) == 0);
+		ASSERT(path.keys[1].type == JOSH_KEY_TYPE_OBJECT);
+		ASSERT(path.keys[1].num == 3);
+		ASSERT(path.keys[0].hash == path.keys[1].hash);
+		ASSERT(path.keys[0].hash != other.keys[0].hash);
+		ASSERT(path.keys[2].type == JOSH_KEY_TYPE_ARRAY);
+		ASSERT(path.keys[2].num == 1);
+	}
+
+	TEST("escaped object keys match their decoded name") {
+		const char *json = "{\"a\\u0062\": 1, \"\\ud83d\\ude00\": 2, \"x\\ud800\": 3, \"a\\\\b\": 4}";
+
+		ASSERT(josh_extract(&ctx, json, ".ab") == json + 12);
+		ASSERT(josh_extract(&ctx, json, "[\"\xf0\x9f\x98\x80\"]") == json + 31);
+		ASSERT(josh_extract(&ctx, json, "[\"x\xef\xbf\xbd\"]") == json + 45);
+		ASSERT(josh_extract(&ctx, json, "[\"\\ud83d\\ude00\"]") == json + 31);
+		ASSERT(josh_extract(&ctx, json, "[\"a\\\\b\"]") == json + 56);
+		ASSERT(!josh_extract(&ctx, json, ".a"));
+		ASSERT(ctx.error_id == JOSH_ERROR_OBJECT_KEY_NOT_FOUND);
 
-		ASSERT(josh_is_array(root));
-		ASSERT(josh_is_array_empty(root));
+		char long_key[300] = "{\"";
+		memset(long_key + 2, 'k', 200);
+		strcpy(long_key + 202, "\\u006b\": 5}");
+
+		char long_path[300] = ".";
+		memset(long_path + 1, 'k', 201);
+		long_path[202] = '\0';
+
+		ASSERT(josh_extract(&ctx, long_key, long_path));
+		ASSERT(ctx.len == 1);
+
+		// Long keys are decoded while being compared, without allocating.
+		char escaped_key[1024] = "{\"";
+
+		for (unsigned i = 0; i < 130; i++) strcat(escaped_key, "\\u0061");
+		strcat(escaped_key, "\": 6, \"b\": 7}");
+
+		char escaped_path[140] = ".";
+		memset(escaped_path + 1, 'a', 130);
+		escaped_path[131] = '\0';
+
+		ASSERT(josh_extract(&ctx, escaped_key, escaped_path));
+		ASSERT(ctx.len == 1 && ctx.error_id == JOSH_ERROR_NONE);
+		ASSERT(!josh_extract(&ctx, escaped_key, ".aaa"));
+		ASSERT(ctx.error_id == JOSH_ERROR_OBJECT_KEY_NOT_FOUND);
+		ASSERT(josh_extract(&ctx, escaped_key, ".b"));
+		ASSERT(ctx.len == 1);
 	}
 
-	TEST("parse empty object node") {
-		const char *json = "{}";
+	TEST("set error for invalid escape in string key") {
+		struct josh_path_t path;
 
-		struct josh_node_t *root = josh_parse(&ctx, json);
+		josh_reset(&ctx);
 
-		ASSERT(root);
-		ASSERT(root->type == JOSH_NODE_TYPE_OBJECT);
+		ASSERT(!josh_compile_key(&ctx, &path, "[\"a\\qb\"]"));
+		ASSERT(ctx.error_id == JOSH_ERROR_INVALID_ESCAPE_CODE);
+		ASSERT(!josh_compile_key(&ctx, &path, "[\"a\\u12\"]"));
+		ASSERT(ctx.error_id == JOSH_ERROR_INVALID_UNICODE_ESCAPE_CODE);
+		ASSERT(josh_compile_key(&ctx, &path, "[\"a\\u0062\"]"));
+		ASSERT(path.keys[0].num == 2);
+		ASSERT(path.keys[0].hash == josh_hash("ab", 2));
+	}
 
-		ASSERT(josh_is_object(root));
-		ASSERT(josh_is_object_empty(root));
+	TEST("compiled key can be reused") {
+		struct josh_path_t path;
+
+		ASSERT(josh_compile_key(&ctx, &path, ".a[1]"));
+
+		const char *json = "{\"a\": [1, 2]}";
+		const char *out = josh_extract_compiled(&ctx, json, &path);
+
+		ASSERT(out == json + 10);
+		ASSERT(ctx.len == 1);
+
+		json = "{\"b\": 1, \"a\": [true, null]}";
+		out = josh_extract_compiled(&ctx, json, &path);
+
+		ASSERT(out == json + 21);
+		ASSERT(ctx.len == 4);
+
+		json = "{\"a\": []}";
+		out = josh_extract_compiled(&ctx, json, &path);
+
+		ASSERT(!out);
+		ASSERT(ctx.error_id == JOSH_ERROR_ARRAY_INDEX_NOT_FOUND);
+	}
+
+	TEST("extract from nesting deeper than keys can go") {
+		char json[2 * JOSH_CONFIG_MAX_NESTING + 2];
+		char key[4 * JOSH_CONFIG_MAX_DEPTH + 1] = "";
+
+		memset(json, '[', JOSH_CONFIG_MAX_NESTING);
+		json[JOSH_CONFIG_MAX_NESTING] = '7';
+		memset(json + JOSH_CONFIG_MAX_NESTING + 1, ']', JOSH_CONFIG_MAX_NESTING);
+		json[sizeof(json) - 1] = '\0';
+
+		for (unsigned i = 0; i < JOSH_CONFIG_MAX_DEPTH; i++) {
+			strcat(key, "[0]");
+		}
+
+		const char *out = josh_extract(&ctx, json, key);
+
+		ASSERT(out == json + JOSH_CONFIG_MAX_DEPTH);
+		ASSERT(ctx.len == 2 * (JOSH_CONFIG_MAX_NESTING - JOSH_CONFIG_MAX_DEPTH) + 1);
+
+		ASSERT(josh_parse(&ctx, json));
+		ASSERT(ctx.node_count == JOSH_CONFIG_MAX_NESTING + 1);
+		ASSERT(josh_array_size(ctx.root + JOSH_CONFIG_MAX_NESTING - 1) == 1);
+	}
+
+	TEST("set error when nesting too deep") {
+		char json[JOSH_CONFIG_MAX_NESTING + 2];
+
+		memset(json, '[', sizeof(json) - 1);
+		json[sizeof(json) - 1] = '\0';
+
+		ASSERT(!josh_extract(&ctx, json, "[1]"));
+		ASSERT(ctx.error_id == JOSH_ERROR_MAX_NESTING_REACHED);
+		ASSERT(ctx.offset == JOSH_CONFIG_MAX_NESTING);
+
+		ASSERT(!josh_parse(&ctx, json));
+		ASSERT(ctx.error_id == JOSH_ERROR_MAX_NESTING_REACHED);
+	}
+
+	TEST("path validation skips values no key is looking in") {
+		const char *json = "{\"a\": {\"x\": [1, \"\\q]\", tru, 0x]}, \"b\": [\"}\", {\"c\": 2}]}";
+		struct josh_ctx_t trusted = { .validation = JOSH_VALIDATION_PATH };
+
+		ASSERT(!josh_extract(&ctx, json, ".b[1].c"));
+		ASSERT(ctx.error_id == JOSH_ERROR_INVALID_ESCAPE_CODE);
+
+		const char *out = josh_extract(&trusted, json, ".b[1].c");
+
+		ASSERT(out == json + 51);
+		ASSERT(trusted.len == 1);
+
+		ASSERT(!josh_extract(&trusted, json, ".a.x"));
+		ASSERT(trusted.error_id == JOSH_ERROR_INVALID_ESCAPE_CODE);
+
+		ASSERT(!josh_extract(&trusted, "{\"a\": [1, [}, \"b\": 2}", ".b"));
+		ASSERT(trusted.error_id == JOSH_ERROR_UNEXPECTED_CHAR);
+	}
+
+	TEST("extract many compiled keys at once") {
+		struct josh_path_t paths[2];
+
+		ASSERT(josh_compile_key(&ctx, &paths[0], ".y"));
+		ASSERT(josh_compile_key(&ctx, &paths[1], ".x"));
+
+		const char *json = "{\"x\": 1, \"y\": 2}";
+		struct josh_result_t results[2];
+
+		const bool ok = josh_extract_many_compiled(&ctx, json, paths, results, 2);
+
+		ASSERT(ok);
+		ASSERT(results[0].ptr == json + 14);
+		ASSERT(results[1].ptr == json + 6);
+	}
+
+	TEST("compile wildcard keys") {
+		struct josh_path_t path;
+
+		josh_reset(&ctx);
+
+		ASSERT(josh_compile_key(&ctx, &path, ".items[*].*[0]"));
+		ASSERT(path.key_count == 4);
+		ASSERT(!path.keys[0].wildcard);
+		ASSERT(path.keys[1].type == JOSH_KEY_TYPE_ARRAY && path.keys[1].wildcard);
+		ASSERT(path.keys[2].type == JOSH_KEY_TYPE_OBJECT && path.keys[2].wildcard);
+		ASSERT(!path.keys[3].wildcard);
+		ASSERT(!josh_compile_key(&ctx, &path, ".*a"));
+		ASSERT(ctx.error_id == JOSH_ERROR_INVALID_KEY_OBJECT);
+	}
+
+	TEST("extract all values matching wildcards") {
+		const char *json = "{\"items\": [{\"price\": 1}, {\"name\": \"x\"}, {\"price\": 2.5}], \"n\": {\"a\": true, \"b\": null}}";
+		struct josh_result_t results[4];
+
+		ASSERT(josh_extract_all(&ctx, json, ".items[*].price", results, 4) == 2);
+		ASSERT(results[0].ptr == json + 21 && results[0].len == 1);
+		ASSERT(results[1].ptr == json + 50 && results[1].len == 3);
+
+		ASSERT(josh_extract_all(&ctx, json, ".items[*].price", results, 1) == 2);
+		ASSERT(josh_extract_all(&ctx, json, ".n.*", results, 4) == 2);
+		ASSERT(results[0].len == 4 && results[1].len == 4);
+		ASSERT(josh_extract_all(&ctx, json, ".n", results, 4) == 1);
+
+		ASSERT(josh_extract_all(&ctx, json, ".items[*].size", results, 4) == 0);
+		ASSERT(ctx.error_id == JOSH_ERROR_OBJECT_KEY_NOT_FOUND);
+		ASSERT(josh_extract_all(&ctx, "[1, 2", "[*]", results, 4) == 0);
+		ASSERT(ctx.error_id);
+
+		// Without a callback, only the first match is extracted.
+		ASSERT(josh_extract(&ctx, json, ".items[*].price") == json + 21);
+		ASSERT(josh_extract(&ctx, json, "[*]") == NULL);
+		ASSERT(ctx.error_id == JOSH_ERROR_EXPECTED_ARRAY);
+	}
+
+	TEST("compile array slice keys") {
+		struct josh_path_t path;
+
+		josh_reset(&ctx);
+
+		ASSERT(josh_compile_key(&ctx, &path, "[1:5:2][:3][2:][::4][7]"));
+		ASSERT(path.key_count == 5);
+		ASSERT(path.keys[0].wildcard && path.keys[0].num == 1);
+		ASSERT(path.slices[0].end == 5 && path.slices[0].step == 2);
+		ASSERT(path.keys[1].num == 0 && path.slices[1].end == 3 && path.slices[1].step == 1);
+		ASSERT(path.keys[2].num == 2 && path.slices[2].end == UINT_MAX);
+		ASSERT(path.keys[3].num == 0 && path.slices[3].step == 4);
+		ASSERT(!path.keys[4].wildcard && path.keys[4].num == 7);
+
+		ASSERT(!josh_compile_key(&ctx, &path, "[::0]"));
+		ASSERT(ctx.error_id == JOSH_ERROR_KEY_NUMBER_INVALID);
+		ASSERT(!josh_compile_key(&ctx, &path, "[1:2:3:4]"));
+		ASSERT(ctx.error_id == JOSH_ERROR_KEY_NUMBER_INVALID);
+		ASSERT(!josh_compile_key(&ctx, &path, "[1:2"));
+		ASSERT(ctx.error_id == JOSH_ERROR_EXPECTED_KEY_CLOSING_BRACKET);
+	}
+
+	TEST("compile array slice keys counting from the end") {
+		struct josh_path_t path;
+
+		josh_reset(&ctx);
+
+		ASSERT(josh_compile_key(&ctx, &path, "[-3:][:-1][-1][1:-2:2]"));
+		ASSERT(path.key_count == 4);
+		ASSERT(path.keys[0].num == 3 && path.slices[0].start_from_end && !path.slices[0].end_from_end);
+		ASSERT(path.slices[1].end == 1 && !path.slices[1].start_from_end && path.slices[1].end_from_end);
+		ASSERT(path.keys[2].wildcard && path.keys[2].num == 1 && path.slices[2].end == 0);
+		ASSERT(path.slices[2].start_from_end && path.slices[2].end_from_end);
+		ASSERT(path.keys[3].num == 1 && path.slices[3].end == 2 && path.slices[3].step == 2);
+
+		ASSERT(!josh_compile_key(&ctx, &path, "[-0]"));
+		ASSERT(ctx.error_id == JOSH_ERROR_KEY_NUMBER_INVALID);
+		ASSERT(!josh_compile_key(&ctx, &path, "[::-1]"));
+		ASSERT(ctx.error_id == JOSH_ERROR_KEY_NUMBER_INVALID);
+		ASSERT(!josh_compile_key(&ctx, &path, "[-:]"));
+		ASSERT(ctx.error_id == JOSH_ERROR_KEY_NUMBER_INVALID);
+		ASSERT(!josh_compile_key(&ctx, &path, "[--1]"));
+		ASSERT(ctx.error_id == JOSH_ERROR_KEY_NUMBER_INVALID);
+	}
+
+	TEST("extract array slices") {
+		const char *json = "[0, 1, 2, 3, 4, 5, 6, 7, 8, 9]";
+		struct josh_result_t results[10];
+
+		ASSERT(josh_extract_all(&ctx, json, "[2:5]", results, 10) == 3);
+		ASSERT(results[0].ptr[0] == '2' && results[2].ptr[0] == '4');
+		ASSERT(josh_extract_all(&ctx, json, "[1::4]", results, 10) == 3);
+		ASSERT(results[0].ptr[0] == '1' && results[1].ptr[0] == '5' && results[2].ptr[0] == '9');
+		ASSERT(josh_extract_all(&ctx, json, "[:3]", results, 10) == 3);
+		ASSERT(josh_extract_all(&ctx, json, "[8:20]", results, 10) == 2);
+		ASSERT(josh_extract_all(&ctx, json, "[20:]", results, 10) == 0);
+		ASSERT(ctx.error_id == JOSH_ERROR_ARRAY_INDEX_NOT_FOUND);
+		ASSERT(josh_extract(&ctx, json, "[3:]") == json + 10);
+	}
+
+	TEST("extract array slices counting from the end") {
+		const char *json = "[0, 1, 2, 3, 4, 5, 6, 7, 8, 9]";
+		struct josh_result_t results[10];
+
+		ASSERT(josh_extract(&ctx, json, "[-1]") == json + 28);
+		ASSERT(ctx.len == 1);
+		ASSERT(josh_extract_all(&ctx, json, "[-3:]", results, 10) == 3);
+		ASSERT(results[0].ptr[0] == '7' && results[2].ptr[0] == '9');
+		ASSERT(josh_extract_all(&ctx, json, "[:-8]", results, 10) == 2);
+		ASSERT(results[1].ptr[0] == '1');
+		ASSERT(josh_extract_all(&ctx, json, "[-4:-1:2]", results, 10) == 2);
+		ASSERT(results[0].ptr[0] == '6' && results[1].ptr[0] == '8');
+		ASSERT(josh_extract_all(&ctx, json, "[-20:2]", results, 10) == 2);
+		ASSERT(!josh_extract(&ctx, json, "[-11]"));
+		ASSERT(ctx.error_id == JOSH_ERROR_ARRAY_INDEX_NOT_FOUND);
+		ASSERT(!josh_extract(&ctx, "[]", "[-1]"));
+		ASSERT(ctx.error_id == JOSH_ERROR_ARRAY_INDEX_NOT_FOUND);
+
+		// Each array is counted on its own, nested or not.
+		ASSERT(josh_extract_all(&ctx, "[[0, 1, 2], [3, 4], [5]]", "[*][-1]", results, 10) == 3);
+		ASSERT(results[0].ptr[0] == '2' && results[1].ptr[0] == '4' && results[2].ptr[0] == '5');
+		ASSERT(josh_extract(&ctx, "{\"a\": [{\"b\": [1, \"]\"]}, {\"b\": 2}]}", ".a[-2].b[-1]"));
+		ASSERT(ctx.len == 3);
+		ASSERT(josh_extract(&ctx, "{\"a\": [1, 2], \"b\": 3}", ".a[-1]"));
+		ASSERT(ctx.len == 1);
+	}
+
+	TEST("scanning stops once wildcards cannot match anything else") {
+		struct josh_result_t results[4];
+
+		// Nothing after the end of the slice (or the array) is scanned.
+		ASSERT(josh_extract_all(&ctx, "[0, 1, 2, oops", "[0:2]", results, 4) == 2);
+		ASSERT(josh_extract_all(&ctx, "{\"a\": [{\"b\": 1}, {\"b\": 2}], oops", ".a[*].b", results, 4) == 2);
+
+		// Other arrays could still match a slice after a wildcard.
+		ASSERT(josh_extract_all(&ctx, "[[0, 1, 2], [3, 4], [5]]", "[*][1:]", results, 4) == 3);
+		ASSERT(results[2].ptr[0] == '4');
+	}
+
+	TEST("wildcards look past duplicate keys of the wrong type") {
+		const char *cases[][2] = {
+			{"{\"a\": {}, \"a\": [1]}", ".a[0]"},
+			{"{\"a\": {}, \"a\": [1]}", ".a[*]"},
+			{"{\"a\": {}, \"a\": [1]}", ".a[-1]"},
+			{"{\"a\": [], \"a\": {\"b\": 1}}", ".a.b"},
+			{"{\"a\": [], \"a\": {\"b\": 1}}", ".a.*"},
+		};
+		struct josh_index_entry_t entries[8];
+		struct josh_index_member_t members[8];
+		struct josh_index_t index = { entries, members, 0, 8 };
+
+		for (unsigned i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+			const char *json = cases[i][0];
+			const char *out = josh_extract(&ctx, json, cases[i][1]);
+
+			ASSERT(out && *out == '1');
+			ASSERT(josh_index_build(&ctx, &index, json, strlen(json)));
+			ASSERT(josh_extract_indexed(&ctx, &index, json, cases[i][1]) == out);
+
+			struct josh_path_t path;
+			struct josh_result_t result;
+			struct josh_stream_t stream;
+
+			if (i == 2) continue;
+
+			ASSERT(josh_compile_key(&ctx, &path, cases[i][1]));
+			ASSERT(josh_stream_init(&stream, &path, &result, 1));
+			ASSERT(josh_stream_feed(&stream, json, strlen(json)));
+			ASSERT(josh_stream_finish(&stream));
+			ASSERT(result.ptr == out);
+		}
+	}
+
+	TEST("callback is called for every wildcard match") {
+		const char *json = "[[1, 2], [], [3]]";
+		const char *keys[2] = {"[*][*]", "[2]"};
+		struct josh_result_t results[2];
+
+		ctx.callback = stream_callback;
+		stream_emitted = 0;
+
+		ASSERT(josh_extract_many(&ctx, json, keys, results, 2));
+		ASSERT(stream_emitted == 4);
+		ASSERT(results[0].ptr == json + 14);
+		ASSERT(results[1].ptr == json + 13);
+
+		ctx.callback = NULL;
+	}
+
+	TEST("cursor iterates array elements") {
+		const char *json = "{\"a\": [1, \"two\" , [3],{\"four\": 4}], \"b\": []}";
+		struct josh_cursor_t cursor;
+		size_t len = 0;
+
+		const char *array = josh_extract(&ctx, json, ".a");
+
+		ASSERT(josh_cursor_enter(&ctx, &cursor, array, ctx.len));
+		ASSERT(josh_cursor_next(&ctx, &cursor));
+		ASSERT(cursor.index == 0);
+		ASSERT(josh_cursor_value_span(&cursor, &len) == json + 7 && len == 1);
+		ASSERT(!josh_cursor_key(&cursor, &len));
+		ASSERT(josh_cursor_next(&ctx, &cursor));
+		ASSERT(josh_cursor_value_span(&cursor, &len) == json + 10 && len == 5);
+		ASSERT(josh_cursor_next(&ctx, &cursor));
+		ASSERT(josh_cursor_value_span(&cursor, &len) == json + 18 && len == 3);
+		ASSERT(josh_cursor_next(&ctx, &cursor));
+		ASSERT(cursor.index == 3);
+
+		// The current element can be entered in turn.
+		struct josh_cursor_t inner;
+		const char *object = josh_cursor_value_span(&cursor, &len);
+
+		ASSERT(josh_cursor_enter(&ctx, &inner, object, len));
+		ASSERT(josh_cursor_next(&ctx, &inner));
+		ASSERT(josh_cursor_key(&inner, &len) == json + 24 && len == 4);
+		ASSERT(josh_cursor_value_span(&inner, &len) == json + 31 && len == 1);
+		ASSERT(!josh_cursor_next(&ctx, &inner));
+		ASSERT(!ctx.error_id);
+
+		ASSERT(!josh_cursor_next(&ctx, &cursor));
+		ASSERT(!ctx.error_id);
+		ASSERT(!josh_cursor_next(&ctx, &cursor));
+
+		array = josh_extract(&ctx, json, ".b");
+
+		ASSERT(josh_cursor_enter(&ctx, &cursor, array, ctx.len));
+		ASSERT(!josh_cursor_next(&ctx, &cursor));
+		ASSERT(!ctx.error_id);
+	}
+
+	TEST("cursor iterates object members") {
+		const char *json = " {\"x\": {\"y\": [1, 2]}, \"z\\n\": null} ";
+		struct josh_cursor_t cursor;
+		const char *key = NULL;
+		const char *value = NULL;
+		size_t key_len = 0;
+		size_t value_len = 0;
+
+		ASSERT(josh_cursor_enter(&ctx, &cursor, json, strlen(json)));
+		ASSERT(josh_cursor_next(&ctx, &cursor));
+
+		key = josh_cursor_key(&cursor, &key_len);
+		value = josh_cursor_value_span(&cursor, &value_len);
+
+		ASSERT(key_len == 1 && strncmp(key, "x", key_len) == 0);
+		ASSERT(value_len == 13 && strncmp(value, "{\"y\": [1, 2]}", value_len) == 0);
+		ASSERT(josh_cursor_next(&ctx, &cursor));
+
+		key = josh_cursor_key(&cursor, &key_len);
+		value = josh_cursor_value_span(&cursor, &value_len);
+
+		ASSERT(key_len == 3 && strncmp(key, "z\\n", key_len) == 0);
+		ASSERT(value_len == 4 && strncmp(value, "null", value_len) == 0);
+		ASSERT(!josh_cursor_next(&ctx, &cursor));
+		ASSERT(!ctx.error_id);
+	}
+
+	TEST("cursor reports errors") {
+		struct josh_cursor_t cursor;
+
+		ASSERT(!josh_cursor_enter(&ctx, &cursor, "12", 2));
+		ASSERT(ctx.error_id == JOSH_ERROR_EXPECTED_CONTAINER);
+		ASSERT(!josh_cursor_enter(&ctx, &cursor, " \"[1]\"", 6));
+		ASSERT(ctx.error_id == JOSH_ERROR_EXPECTED_CONTAINER);
+		ASSERT(ctx.offset == 1);
+
+		ASSERT(josh_cursor_enter(&ctx, &cursor, "[1 2]", 5));
+		ASSERT(josh_cursor_next(&ctx, &cursor));
+		ASSERT(!josh_cursor_next(&ctx, &cursor));
+		ASSERT(ctx.error_id == JOSH_ERROR_UNEXPECTED_CHAR);
+
+		ASSERT(josh_cursor_enter(&ctx, &cursor, "[tru]", 5));
+		ASSERT(!josh_cursor_next(&ctx, &cursor));
+		ASSERT(ctx.error_id == JOSH_ERROR_EXPECTED_TRUE);
+
+		ASSERT(josh_cursor_enter(&ctx, &cursor, "{\"a\" 1}", 7));
+		ASSERT(!josh_cursor_next(&ctx, &cursor));
+		ASSERT(ctx.error_id == JOSH_ERROR_EXPECTED_COLON);
+
+		// The span is bounded, even when the JSON carries on after it.
+		ASSERT(josh_cursor_enter(&ctx, &cursor, "[1, 2]", 4));
+		ASSERT(josh_cursor_next(&ctx, &cursor));
+		ASSERT(!josh_cursor_next(&ctx, &cursor));
+		ASSERT(ctx.error_id);
+	}
+
+	TEST("extract from document index") {
+		const char *json = " {\"a\": [1, {\"b\\u0063\": \"x\"}], \"d\": {\"e\": null, \"e\": 2}, \"\": []} ";
+		const char *keys[] = {"", ".a", ".a[0]", ".a[1].bc", ".d.e", "[\"\"]", ".a[1:]", ".d.*"};
+		struct josh_index_entry_t entries[16];
+		struct josh_index_member_t members[16];
+		struct josh_index_t index = { entries, members, 0, 16 };
+
+		ASSERT(josh_index_build(&ctx, &index, json, strlen(json)));
+		ASSERT(index.count == 9);
+
+		for (unsigned i = 0; i < sizeof(keys) / sizeof(keys[0]); i++) {
+			const char *expected = josh_extract(&ctx, json, keys[i]);
+			const size_t len = ctx.len;
+
+			ASSERT(expected);
+			ASSERT(josh_extract_indexed(&ctx, &index, json, keys[i]) == expected);
+			ASSERT(ctx.len == len);
+		}
+
+		ASSERT(!josh_extract_indexed(&ctx, &index, json, ".a[2]"));
+		ASSERT(ctx.error_id == JOSH_ERROR_ARRAY_INDEX_NOT_FOUND);
+		ASSERT(!josh_extract_indexed(&ctx, &index, json, ".d.f"));
+		ASSERT(ctx.error_id == JOSH_ERROR_OBJECT_KEY_NOT_FOUND);
+		ASSERT(!josh_extract_indexed(&ctx, &index, json, ".a.b"));
+		ASSERT(ctx.error_id == JOSH_ERROR_OBJECT_KEY_NOT_FOUND);
+		ASSERT(!josh_extract_indexed(&ctx, &index, json, ".a[0:0]"));
+
+		// The index only holds offsets, so a copy of it works just as well.
+		struct josh_index_entry_t saved_entries[16];
+		struct josh_index_member_t saved_members[16];
+		struct josh_index_t saved = { saved_entries, saved_members, index.count, 16 };
+
+		memcpy(saved_entries, entries, sizeof(entries));
+		memcpy(saved_members, members, sizeof(members));
+
+		ASSERT(josh_extract_indexed(&ctx, &saved, json, ".a[1].bc") == strstr(json, "\"x\""));
+	}
+
+	TEST("document index agrees with scanning") {
+		const char *cases[][2] = {
+			{"[1, {\"a\": 2}]", "[*].a"},
+			{"[[1], [2, 3], [4, 5, 6]]", "[*][2]"},
+			{"[[1], [2, 3], [4, 5, 6]]", "[1:][1]"},
+			{"[[1], [2, 3], [4, 5, 6]]", "[:2][2]"},
+			{"[[1], [2, 3], [4, 5, 6]]", "[::2][1]"},
+			{"[[1], [2, 3], [4, 5, 6]]", "[0:0][0]"},
+			{"[[1], [2, 3], [4, 5, 6]]", "[2:1][0]"},
+			{"[[1], [2, 3], [4, 5, 6]]", "[1:2][5]"},
+			{"[[1], [2, 3], [4, 5, 6] ]", "[1:3][5]"},
+			{"[[1], [2, 3], [4, 5, 6] ]", "[1:][5]"},
+			{"[ ]", "[:1][0]"},
+			{"[[1] , [2]]", "[:1][5]"},
+			{"{\"a\": [1], \"b\": {\"c\": 5}}", ".*.c"},
+			{"{\"b\": {\"x\": 1}, \"a\": {\"c\": 5}}", ".*.c"},
+			{"{\"a\": 1, \"a\": {\"b\": 2}}", ".a.b"},
+			{"{\"a\": [1], \"a\": {\"b\": 2}}", ".a.b"},
+			{"{\"a\": {}, \"a\": {\"b\": 2}}", ".a.b"},
+			{"{\"a\": {\"c\": 1}}", ".a.b"},
+			{"{\"a\": 1}", ".a.b"},
+			{"{\"a\": {\"b\": 1}}", ".a[0]"},
+			{"[1, [2]]", "[0][0]"},
+			{"[[1], [2]]", "[*].a"},
+			{"{\"x\": [{}, {\"y\": 1}]}", ".x[*].y"},
+			{"{\"x\": [{}, {\"y\": 1}]}", ".z[*].y"},
+			{"5", ".a"},
+			{"5", "[0]"},
+			{"  [1, 2]  ", ""},
+			{"[[1], [2, 3], [4, 5, 6]]", "[-1][0]"},
+			{"[[1], [2, 3], [4, 5, 6]]", "[-2:][1]"},
+			{"[[1], [2, 3], [4, 5, 6]]", "[:-1][1]"},
+			{"[[1], [2, 3], [4, 5, 6] ]", "[:-1][5]"},
+			{"[[1], [2, 3], [4, 5, 6] ]", "[-5:-2][2]"},
+			{"[[1] , [2]]", "[-9][0]"},
+		};
+		struct josh_index_entry_t entries[16];
+		struct josh_index_member_t members[16];
+		struct josh_index_t index = { entries, members, 0, 16 };
+
+		for (unsigned i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+			const char *json = cases[i][0];
+			const char *expected = josh_extract(&ctx, json, cases[i][1]);
+			const size_t len = ctx.len;
+			const enum josh_error error_id = ctx.error_id;
+			const size_t offset = ctx.offset;
+
+			ASSERT(josh_index_build(&ctx, &index, json, strlen(json)));
+			ASSERT(josh_extract_indexed(&ctx, &index, json, cases[i][1]) == expected);
+			ASSERT(ctx.len == len);
+			ASSERT(ctx.error_id == error_id);
+			ASSERT(ctx.offset == offset);
+		}
+	}
+
+	TEST("document index reports errors") {
+		struct josh_index_entry_t entries[4];
+		struct josh_index_member_t members[4];
+		struct josh_index_t index = { entries, members, 0, 4 };
+
+		ASSERT(!josh_index_build(&ctx, &index, "[1, 2, 3, 4]", 12));
+		ASSERT(ctx.error_id == JOSH_ERROR_OUT_OF_MEMORY);
+		ASSERT(!josh_index_build(&ctx, &index, "[1, 2", 5));
+		ASSERT(ctx.error_id == JOSH_ERROR_UNEXPECTED_CHAR);
+		ASSERT(!josh_index_build(&ctx, &index, "{\"a\": 1} 2", 11));
+		ASSERT(ctx.error_id == JOSH_ERROR_UNEXPECTED_CHAR);
+		ASSERT(!josh_index_build(&ctx, &index, "   ", 3));
+		ASSERT(ctx.error_id == JOSH_ERROR_EMPTY_VALUE);
+		ASSERT(josh_index_build(&ctx, &index, "[1, 2]xyz", 6));
+	}
+
+	TEST("stream keys from chunks") {
+		struct josh_path_t paths[3];
+
+		ASSERT(josh_compile_key(&ctx, &paths[0], ".a[1]"));
+		ASSERT(josh_compile_key(&ctx, &paths[1], "[\"b\\n\"]"));
+		ASSERT(josh_compile_key(&ctx, &paths[2], ".c"));
+
+		const char *json = "{\"a\": [true, \"xy\"], \"b\\n\": {\"d\": 1.5e3}, \"c\": \"z\"}";
+		struct josh_result_t results[3];
+		struct josh_stream_t stream;
+
+		ASSERT(josh_stream_init(&stream, paths, results, 3));
+
+		stream.callback = stream_callback;
+		stream_emitted = 0;
+
+		// Feed one byte at a time, from a buffer which is overwritten between
+		// chunks, so nothing can point back into an earlier chunk.
+		const size_t len = strlen(json);
+		size_t i = 0;
+		char chunk = 0;
+
+		for (; i < len && !stream.done; i++) {
+			chunk = json[i];
+			ASSERT(josh_stream_feed(&stream, &chunk, 1));
+
+			// The first key is emitted as soon as its value ends.
+			if (i == 15) ASSERT(stream_emitted == 0);
+			if (i == 16) ASSERT(stream_emitted == 1);
+		}
+
+		ASSERT(josh_stream_finish(&stream));
+		ASSERT(stream_emitted == 3);
+		ASSERT(i == len - 1);
+
+		ASSERT(!results[0].error_id);
+		ASSERT(results[0].offset == 13);
+		ASSERT(results[0].len == 4);
+		ASSERT(!results[1].error_id);
+		ASSERT(results[1].offset == 27);
+		ASSERT(results[1].len == 12);
+		ASSERT(!results[2].error_id);
+		ASSERT(results[2].offset == 46);
+		ASSERT(results[2].len == 3);
+	}
+
+	TEST("stream copies values spanning chunks into arena") {
+		struct josh_path_t path;
+
+		ASSERT(josh_compile_key(&ctx, &path, ".a"));
+
+		struct josh_result_t result;
+		struct josh_stream_t stream;
+
+		ASSERT(josh_stream_init(&stream, &path, &result, 1));
+
+		stream.callback = stream_callback;
+		stream_value[0] = '\0';
+
+		ASSERT(josh_stream_feed(&stream, "{\"a\": [1, ", 10));
+		ASSERT(josh_stream_feed(&stream, "2, 3]}", 6));
+		ASSERT(josh_stream_finish(&stream));
+		ASSERT(!result.error_id);
+		ASSERT(!result.ptr);
+		ASSERT(result.len == 9);
+
+		struct josh_arena_t growing;
+		josh_arena_init(&growing, NULL, 0);
+
+		ASSERT(josh_stream_init(&stream, &path, &result, 1));
+
+		stream.callback = stream_callback;
+		stream.arena = &growing;
+
+		ASSERT(josh_stream_feed(&stream, "{\"a\": [1, ", 10));
+		ASSERT(josh_stream_feed(&stream, "2, 3]}", 6));
+		ASSERT(josh_stream_finish(&stream));
+		ASSERT(strcmp(stream_value, "[1, 2, 3]") == 0);
+
+		josh_arena_free(&growing);
+	}
+
+	TEST("stream keeps copied values after later ones are copied") {
+		struct josh_path_t paths[2];
+
+		ASSERT(josh_compile_key(&ctx, &paths[0], "[1][1]"));
+		ASSERT(josh_compile_key(&ctx, &paths[1], "[2]"));
+
+		const char *json = "[null,[-878,334,806],true]";
+		struct josh_result_t results[2];
+		struct josh_stream_t stream;
+		struct josh_arena_t growing;
+		josh_arena_init(&growing, NULL, 0);
+
+		ASSERT(josh_stream_init(&stream, paths, results, 2));
+
+		stream.arena = &growing;
+
+		// Feed 2 bytes at a time from a buffer which is overwritten between
+		// chunks, so "334" and "true" both have to be copied.
+		const size_t len = strlen(json);
+		char chunk[2];
+
+		for (size_t i = 0; i < len; i += 2) {
+			memcpy(chunk, json + i, 2);
+			ASSERT(josh_stream_feed(&stream, chunk, 2));
+		}
+
+		ASSERT(josh_stream_finish(&stream));
+		ASSERT(results[0].offset == 12);
+		ASSERT(results[0].len == 3);
+		ASSERT(results[0].ptr && strncmp(results[0].ptr, "334", 3) == 0);
+		ASSERT(results[1].offset == 21);
+		ASSERT(results[1].len == 4);
+		ASSERT(results[1].ptr && strncmp(results[1].ptr, "true", 4) == 0);
+
+		josh_arena_free(&growing);
+	}
+
+	TEST("stream matches escaped object keys") {
+		struct josh_path_t paths[3];
+
+		ASSERT(josh_compile_key(&ctx, &paths[0], ".ab"));
+		ASSERT(josh_compile_key(&ctx, &paths[1], "[\"\xf0\x9f\x98\x80\"]"));
+		ASSERT(josh_compile_key(&ctx, &paths[2], "[\"x\\ud800\"]"));
+
+		const char *json = "{\"a\\u0062\": 1, \"\\ud83d\\ude00\": 2, \"x\\ud800\": 3}";
+		struct josh_result_t results[3];
+		struct josh_stream_t stream;
+
+		ASSERT(josh_stream_init(&stream, paths, results, 3));
+
+		// Feed one byte at a time, so escapes are split between chunks.
+		for (size_t i = 0; json[i]; i++) ASSERT(josh_stream_feed(&stream, json + i, 1));
+
+		ASSERT(josh_stream_finish(&stream));
+		ASSERT(!results[0].error_id && results[0].offset == 12);
+		ASSERT(!results[1].error_id && results[1].offset == 31);
+		ASSERT(!results[2].error_id && results[2].offset == 45);
+
+		ASSERT(josh_compile_key(&ctx, &paths[0], ".a"));
+		ASSERT(josh_stream_init(&stream, paths, results, 1));
+		ASSERT(josh_stream_feed(&stream, json, strlen(json)));
+		ASSERT(!josh_stream_finish(&stream));
+		ASSERT(results[0].error_id == JOSH_ERROR_OBJECT_KEY_NOT_FOUND);
+	}
+
+	TEST("stream and index match long escaped path keys") {
+		// Each char decodes to 2, 4, and 1 bytes, so the decoded name is walked
+		// across chars of every length.
+		char path_key[1024] = "[\"";
+		char json[1024] = "{\"x\": 1, \"";
+
+		for (unsigned i = 0; i < 40; i++) {
+			strcat(path_key, "\\u00e9\\ud83d\\ude00a");
+			strcat(json, (i & 1) ? "\\u00e9\\ud83d\\ude00a" : "\xc3\xa9\xf0\x9f\x98\x80" "a");
+		}
+		strcat(path_key, "\"]");
+		strcat(json, "\": [true]}");
+
+		struct josh_path_t path;
+		struct josh_result_t result;
+		struct josh_stream_t stream;
+
+		ASSERT(josh_compile_key(&ctx, &path, path_key));
+
+		const char *expected = josh_extract(&ctx, json, path_key);
+
+		ASSERT(expected);
+		ASSERT(ctx.len == 6);
+
+		ASSERT(josh_stream_init(&stream, &path, &result, 1));
+		ASSERT(josh_stream_feed(&stream, json, strlen(json)));
+		ASSERT(josh_stream_finish(&stream));
+		ASSERT(result.ptr == expected);
+		ASSERT(result.len == 6);
+
+		struct josh_index_entry_t entries[8];
+		struct josh_index_member_t members[8];
+		struct josh_index_t index = { entries, members, 0, 8 };
+
+		ASSERT(josh_index_build(&ctx, &index, json, strlen(json)));
+		ASSERT(josh_extract_indexed(&ctx, &index, json, path_key) == expected);
+
+		// One byte short of the end of the name.
+		path_key[strlen(path_key) - 3] = '\0';
+		strcat(path_key, "\"]");
+
+		ASSERT(!josh_extract_indexed(&ctx, &index, json, path_key));
+		ASSERT(ctx.error_id == JOSH_ERROR_OBJECT_KEY_NOT_FOUND);
+	}
+
+	TEST("stream reports every wildcard match") {
+		struct josh_path_t paths[2];
+
+		ASSERT(josh_compile_key(&ctx, &paths[0], ".items[*].price"));
+		ASSERT(josh_compile_key(&ctx, &paths[1], ".items[*].size"));
+
+		const char *json = "{\"items\": [{\"price\": 1}, {\"name\": \"x\"}, {\"price\": 2.5}]}";
+		struct josh_result_t results[2];
+		struct josh_stream_t stream;
+
+		ASSERT(josh_stream_init(&stream, paths, results, 2));
+
+		stream.callback = stream_callback;
+		stream_emitted = 0;
+
+		ASSERT(josh_stream_feed(&stream, json, strlen(json)));
+		ASSERT(!josh_stream_finish(&stream));
+		ASSERT(stream_emitted == 3);
+		ASSERT(strcmp(stream_value, "2.5") == 0);
+		ASSERT(!results[0].error_id && results[0].offset == 50);
+		ASSERT(results[1].error_id == JOSH_ERROR_OBJECT_KEY_NOT_FOUND);
+	}
+
+	TEST("stream extracts array slices") {
+		struct josh_path_t path;
+
+		ASSERT(josh_compile_key(&ctx, &path, ".a[1:3]"));
+
+		const char *json = "{\"a\": [10, 11, 12, 13], \"b\": oops";
+		struct josh_result_t result;
+		struct josh_stream_t stream;
+
+		ASSERT(josh_stream_init(&stream, &path, &result, 1));
+
+		stream.callback = stream_callback;
+		stream_emitted = 0;
+
+		ASSERT(josh_stream_feed(&stream, json, strlen(json)));
+		ASSERT(josh_stream_finish(&stream));
+		ASSERT(stream.done);
+		ASSERT(stream_emitted == 2);
+		ASSERT(strcmp(stream_value, "12") == 0);
+	}
+
+	TEST("stream rejects slices counting from the end") {
+		struct josh_path_t path;
+		struct josh_result_t result;
+		struct josh_stream_t stream;
+
+		ASSERT(josh_compile_key(&ctx, &path, ".a[-1]"));
+		ASSERT(!josh_stream_init(&stream, &path, &result, 1));
+		ASSERT(stream.error_id == JOSH_ERROR_KEY_NOT_STREAMABLE);
+		ASSERT(!josh_stream_feed(&stream, "{}", 2));
+	}
+
+	TEST("stream reports errors") {
+		struct josh_path_t paths[2];
+
+		ASSERT(josh_compile_key(&ctx, &paths[0], ".a"));
+		ASSERT(josh_compile_key(&ctx, &paths[1], ".b"));
+
+		struct josh_result_t results[2];
+		struct josh_stream_t stream;
+
+		ASSERT(josh_stream_init(&stream, paths, results, 2));
+		ASSERT(josh_stream_feed(&stream, "{\"a\": 1, \"b\": [", 15));
+		ASSERT(!josh_stream_finish(&stream));
+		ASSERT(!results[0].error_id);
+		ASSERT(results[1].error_id == JOSH_ERROR_EXPECTED_LITERAL);
+
+		ASSERT(josh_stream_init(&stream, paths, results, 2));
+		ASSERT(!josh_stream_feed(&stream, "{\"a\": tru ", 10));
+		ASSERT(stream.error_id == JOSH_ERROR_EXPECTED_TRUE);
+		ASSERT(stream.offset == 9);
+		ASSERT(results[0].error_id == JOSH_ERROR_EXPECTED_TRUE);
+		ASSERT(!josh_stream_feed(&stream, "}", 1));
+
+		char deep[JOSH_CONFIG_MAX_NESTING + 2];
+		memset(deep, '[', sizeof(deep));
+
+		ASSERT(josh_compile_key(&ctx, &paths[0], "[0][0]"));
+		ASSERT(josh_stream_init(&stream, paths, results, 1));
+		ASSERT(!josh_stream_feed(&stream, deep, sizeof(deep)));
+		ASSERT(stream.error_id == JOSH_ERROR_MAX_NESTING_REACHED);
+		ASSERT(stream.offset == JOSH_CONFIG_MAX_NESTING);
+	}
+
+	TEST("stream rejects NUL chars in strings") {
+		struct josh_path_t path;
+		struct josh_result_t result;
+		struct josh_stream_t stream;
+		const char json[] = "[\"a\0b\"]";
+
+		ASSERT(!josh_parse_n(&ctx, json, sizeof(json) - 1));
+		ASSERT(ctx.error_id == JOSH_ERROR_STRING_NOT_CLOSED);
+
+		ASSERT(josh_compile_key(&ctx, &path, "[1]"));
+		ASSERT(josh_stream_init(&stream, &path, &result, 1));
+		ASSERT(!josh_stream_feed(&stream, json, sizeof(json) - 1));
+		ASSERT(stream.error_id == JOSH_ERROR_STRING_NOT_CLOSED);
+		ASSERT(stream.offset == 3);
+		ASSERT(result.error_id == JOSH_ERROR_STRING_NOT_CLOSED);
+
+		// Keys which are being matched are checked too.
+		const char object[] = "{\"a\0\": 1}";
+
+		ASSERT(josh_compile_key(&ctx, &path, ".a"));
+		ASSERT(josh_stream_init(&stream, &path, &result, 1));
+		ASSERT(!josh_stream_feed(&stream, object, sizeof(object) - 1));
+		ASSERT(stream.error_id == JOSH_ERROR_STRING_NOT_CLOSED);
+		ASSERT(stream.offset == 3);
+	}
+
+	TEST("extract from length-bounded input") {
+		const char *json = "{\"a\": [1, \"xy\"]}garbage";
+
+		const char *out = josh_extract_n(&ctx, json, 16, ".a[1]");
+
+		ASSERT(out == json + 10);
+		ASSERT(ctx.len == 4);
+
+		out = josh_extract_n(&ctx, json, 10, ".a[1]");
+
+		ASSERT(!out);
+		ASSERT(ctx.error_id == JOSH_ERROR_EXPECTED_LITERAL);
+		ASSERT(ctx.offset == 10);
+
+		out = josh_extract_n(&ctx, json, 13, ".a[1]");
+
+		ASSERT(!out);
+		ASSERT(ctx.error_id == JOSH_ERROR_STRING_NOT_CLOSED);
+		ASSERT(ctx.offset == 13);
+	}
+
+	TEST("length-bounded input is never read past its end") {
+		const char *docs[] = {"{\"k\": [true, 1]}        ", "\"long string value\"", "-12.5e3", "null"};
+
+		for (unsigned i = 0; i < sizeof(docs) / sizeof(*docs); i++) {
+			const size_t len = strlen(docs[i]);
+			char *json = malloc(len);
+
+			ASSERT(json);
+			memcpy(json, docs[i], len);
+
+			ASSERT(josh_extract_n(&ctx, json, len, "") == json);
+			ASSERT(ctx.len == (i ? len : 16));
+
+			free(json);
+		}
+
+		// The block scanners copy the part of a block within the input rather
+		// than load it whole, wherever the input ends in a block.
+		const char *doc = "{\"a\": {\"x\": \"skip\\\"me\"}, \"b\": [\"long string value\"]}";
+		const size_t doc_len = strlen(doc);
+		struct josh_ctx_t trusted = { .validation = JOSH_VALIDATION_PATH };
+
+		for (size_t lead = 0; lead < 32; lead++) {
+			const size_t trail = lead * 7 % 32;
+			const size_t len = lead + doc_len + trail;
+			char *json = malloc(len);
+
+			ASSERT(json);
+			memset(json, ' ', len);
+			memcpy(json + lead, doc, doc_len);
+
+			const char *out = josh_extract_n(&trusted, json, len, ".b[0]");
+
+			ASSERT(out == json + lead + 31);
+			ASSERT(trusted.len == 19);
+			ASSERT(josh_extract_n(&ctx, json, len, ".b[0]") == out);
+			ASSERT(josh_extract_n(&ctx, json, len - trail - 1, ".b[0]") == out);
+			ASSERT(!josh_extract_n(&ctx, json, lead + 45, ".b[0]"));
+			ASSERT(ctx.error_id == JOSH_ERROR_STRING_NOT_CLOSED);
+
+			free(json);
+		}
+	}
+
+	TEST("literals must match exactly") {
+		ASSERT(!josh_extract(&ctx, "[trux]", "[0]"));
+		ASSERT(ctx.error_id == JOSH_ERROR_EXPECTED_TRUE);
+
+		ASSERT(!josh_extract_n(&ctx, "nullnull", 3, ""));
+		ASSERT(ctx.error_id == JOSH_ERROR_EXPECTED_NULL);
+	}
+
+	TEST("parse null node") {
+		const char *json = "null";
+
+		struct josh_node_t *root = josh_parse(&ctx, json);
+
+		ASSERT(root);
+		ASSERT(root->type == JOSH_NODE_TYPE_NULL);
+
+		ASSERT(josh_is_null(root));
+	}
+
+	TEST("parse true node") {
+		const char *json = "true";
+
+		struct josh_node_t *root = josh_parse(&ctx, json);
+
+		ASSERT(root);
+		ASSERT(root->type == JOSH_NODE_TYPE_TRUE);
+
+		ASSERT(josh_is_true(root));
+		ASSERT(!josh_is_false(root));
+		ASSERT(josh_is_bool(root));
+	}
+
+	TEST("parse false node") {
+		const char *json = "false";
+
+		struct josh_node_t *root = josh_parse(&ctx, json);
+
+		ASSERT(root);
+		ASSERT(root->type == JOSH_NODE_TYPE_FALSE);
+
+		ASSERT(josh_is_false(root));
+		ASSERT(!josh_is_true(root));
+		ASSERT(josh_is_bool(root));
+	}
+
+	TEST("parse int node") {
+		const char *json = "123";
+
+		struct josh_node_t *root = josh_parse(&ctx, json);
+
+		ASSERT(root);
+		ASSERT(root->type == JOSH_NODE_TYPE_INT);
+
+		ASSERT(josh_is_int(root));
+		ASSERT(!josh_is_float(root));
+		ASSERT(josh_is_numeric(root));
+		ASSERT(josh_int_value(root) == 123);
+	}
+
+	TEST("parse negative int node") {
+		const char *json = "-123";
+
+		struct josh_node_t *root = josh_parse(&ctx, json);
+
+		ASSERT(root);
+		ASSERT(root->type == JOSH_NODE_TYPE_INT);
+
+		ASSERT(josh_is_int(root));
+		ASSERT(!josh_is_float(root));
+		ASSERT(josh_is_numeric(root));
+		ASSERT(josh_int_value(root) == -123);
+	}
+
+	TEST("parse long int nodes") {
+		struct josh_node_t *root = josh_parse(&ctx, "1700000000123456789");
+
+		ASSERT(root);
+		ASSERT(josh_is_int(root));
+		ASSERT(josh_int_value(root) == 1700000000123456789LL);
+
+		root = josh_parse(&ctx, "9223372036854775807");
+
+		ASSERT(root);
+		ASSERT(josh_is_int(root));
+		ASSERT(josh_int_value(root) == LLONG_MAX);
+
+		root = josh_parse(&ctx, "-9223372036854775808");
+
+		ASSERT(root);
+		ASSERT(josh_is_int(root));
+		ASSERT(josh_int_value(root) == LLONG_MIN);
+	}
+
+	TEST("parse overflowing int node as float") {
+		struct josh_node_t *root = josh_parse(&ctx, "9223372036854775808");
+
+		ASSERT(root);
+		ASSERT(josh_is_float(root));
+		ASSERT(josh_float_value(root) > 9.2e18);
+
+		root = josh_parse(&ctx, "-123456789012345678901234567890");
+
+		ASSERT(root);
+		ASSERT(josh_is_float(root));
+		ASSERT(josh_float_value(root) < -1.2e29);
+		ASSERT(josh_float_value(root) > -1.3e29);
+	}
+
+	TEST("parse float node") {
+		const char *json = "3.1415";
+
+		struct josh_node_t *root = josh_parse(&ctx, json);
+
+		ASSERT(root);
+		ASSERT(root->type == JOSH_NODE_TYPE_FLOAT);
+
+		ASSERT(josh_is_float(root));
+		ASSERT(!josh_is_int(root));
+		ASSERT(josh_is_numeric(root));
+
+		const double value = josh_float_value(root);
+		const double expected = 3.1415;
+
+		ASSERT((expected - 0.01) < value);
+		ASSERT(value < (expected + 0.01));
+	}
+
+	TEST("parse float node with correct rounding") {
+		const char *inputs[] = {
+			"0.1",
+			"-2.5e-3",
+			"1e23",
+			"9007199254740993.0",
+			"2.2250738585072011e-308",
+			"1.7976931348623157e308",
+			"3.14159265358979323846264338327950288",
+			"123456789012345678901234567890e-10",
+		};
+		const double expected[] = {
+			0.1,
+			-2.5e-3,
+			1e23,
+			9007199254740993.0,
+			2.2250738585072011e-308,
+			1.7976931348623157e308,
+			3.14159265358979323846264338327950288,
+			123456789012345678901234567890e-10,
+		};
+
+		for (size_t i = 0; i < sizeof(inputs) / sizeof(*inputs); i++) {
+			struct josh_node_t *root = josh_parse(&ctx, inputs[i]);
+
+			ASSERT(root);
+			ASSERT(josh_is_float(root));
+
+			const double value = josh_float_value(root);
+
+			ASSERT(!memcmp(&value, &expected[i], sizeof(value)));
+		}
+	}
+
+	TEST("parse float node with zero mantissa") {
+		struct josh_node_t *root = josh_parse(&ctx, "-0.0e400");
+
+		ASSERT(root);
+		ASSERT(josh_is_float(root));
+
+		const double value = josh_float_value(root);
+		const double expected = -0.0;
+
+		ASSERT(!memcmp(&value, &expected, sizeof(value)));
+	}
+
+	TEST("parse empty array node") {
+		const char *json = "[]";
+
+		struct josh_node_t *root = josh_parse(&ctx, json);
+
+		ASSERT(root);
+		ASSERT(root->type == JOSH_NODE_TYPE_ARRAY);
+
+		ASSERT(josh_is_array(root));
+		ASSERT(josh_is_array_empty(root));
+	}
+
+	TEST("parse empty object node") {
+		const char *json = "{}";
+
+		struct josh_node_t *root = josh_parse(&ctx, json);
+
+		ASSERT(root);
+		ASSERT(root->type == JOSH_NODE_TYPE_OBJECT);
+
+		ASSERT(josh_is_object(root));
+		ASSERT(josh_is_object_empty(root));
+	}
+
+	TEST("nodes are compact") {
+		ASSERT(sizeof(struct josh_node_t) <= 16);
+
+		struct josh_arena_t small_arena;
+		static uint8_t small_buffer[1024];
+		josh_arena_init(&small_arena, small_buffer, sizeof(small_buffer));
+		small_arena.alloc = NULL;
+
+		struct josh_ctx_t small = { .arena = &small_arena };
+
+		// 1KB (less the block header) fits 32 nodes after the tape has grown.
+		struct josh_node_t *root = josh_parse(&small, "[true, false, null, 1, 2.5, \"a\", [], {}, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0]");
+
+		ASSERT(root);
+		ASSERT(josh_array_size(root) == 31);
+		ASSERT(josh_is_true(josh_array_get(root, 0)));
+		ASSERT(josh_is_false(josh_array_get(root, 1)));
+		ASSERT(josh_is_null(josh_array_get(root, 2)));
+		ASSERT(josh_int_value(josh_array_get(root, 3)) == 1);
+		ASSERT(josh_float_value(josh_array_get(root, 4)) > 2.4);
+		ASSERT(josh_is_string(josh_array_get(root, 5)));
+		ASSERT(josh_is_array_empty(josh_array_get(root, 6)));
+		ASSERT(josh_is_object_empty(josh_array_get(root, 7)));
+	}
+
+	TEST("parse nested nodes onto tape") {
+		const char *json = "{\"a\": [1, [2, 3], {}], \"b\\n\": \"xyz\", \"c\": null}";
+
+		struct josh_node_t *root = josh_parse(&ctx, json);
+
+		ASSERT(root);
+		ASSERT(ctx.node_count == 12);
+		ASSERT(josh_is_object(root));
+		ASSERT(!josh_is_object_empty(root));
+		ASSERT(josh_object_size(root) == 3);
+		ASSERT(josh_next(root) == root + 12);
+
+		struct josh_node_t *key = josh_first_child(root);
+
+		ASSERT(josh_is_key(key));
+		ASSERT(josh_string_len(key) == 1);
+		ASSERT(josh_string_ptr(json, key) == json + 2);
+
+		struct josh_node_t *array = josh_key_value(key);
+
+		ASSERT(josh_is_array(array));
+		ASSERT(josh_array_size(array) == 3);
+		ASSERT(josh_int_value(josh_array_get(array, 0)) == 1);
+		ASSERT(josh_array_size(josh_array_get(array, 1)) == 2);
+		ASSERT(josh_is_object_empty(josh_array_get(array, 2)));
+		ASSERT(!josh_array_get(array, 3));
+
+		key = josh_next(array);
+
+		ASSERT(josh_is_key(key));
+		ASSERT(josh_string_len(key) == 3);
+		ASSERT(memcmp(josh_string_ptr(json, key), "b\\n", 3) == 0);
+
+		struct josh_node_t *string = josh_key_value(key);
+
+		ASSERT(josh_is_string(string));
+		ASSERT(josh_string_len(string) == 3);
+		ASSERT(memcmp(josh_string_ptr(json, string), "xyz", 3) == 0);
+
+		key = josh_next(string);
+
+		ASSERT(josh_is_null(josh_key_value(key)));
+		ASSERT(josh_next(josh_key_value(key)) == josh_next(root));
+	}
+
+	TEST("string values are only copied when they have escapes") {
+		const char *json = "[\"plain\", \"a\\tb\\u00e9\\ud83d\\ude00\", {\"k\\/\": 1}]";
+
+		struct josh_node_t *root = josh_parse(&ctx, json);
+
+		ASSERT(root);
+
+		struct josh_node_t *plain = josh_array_get(root, 0);
+		size_t len = 0;
+
+		ASSERT(!josh_string_has_escapes(plain));
+		ASSERT(josh_string_value(&ctx, json, plain, &len) == json + 2);
+		ASSERT(len == 5);
+
+		struct josh_node_t *escaped = josh_array_get(root, 1);
+		const char *value = josh_string_value(&ctx, json, escaped, &len);
+
+		ASSERT(josh_string_has_escapes(escaped));
+		ASSERT(value);
+		ASSERT(len == 9);
+		ASSERT(memcmp(value, "a\tb\xc3\xa9\xf0\x9f\x98\x80", 9) == 0);
+
+		struct josh_node_t *key = josh_first_child(josh_array_get(root, 2));
+		value = josh_string_value(&ctx, json, key, &len);
+
+		ASSERT(josh_is_key(key));
+		ASSERT(josh_string_has_escapes(key));
+		ASSERT(len == 2);
+		ASSERT(memcmp(value, "k/", 2) == 0);
+	}
+
+	TEST("unescape string into buffer") {
+		const char *str = "\\\"q\\\" \\u0041\\ud800x\\\\";
+		char out[32];
+
+		const size_t len = josh_unescape(out, str, strlen(str));
+
+		ASSERT(len == 10);
+		ASSERT(memcmp(out, "\"q\" A\xef\xbf\xbdx\\", 10) == 0);
+	}
+
+	TEST("parse string node") {
+		const char *json = "\"\"";
+
+		struct josh_node_t *root = josh_parse(&ctx, json);
+
+		ASSERT(root);
+		ASSERT(josh_is_string(root));
+		ASSERT(josh_string_len(root) == 0);
+		ASSERT(josh_next(root) == root + 1);
+	}
+
+	TEST("extract from file") {
+		char path[] = "/tmp/josh-test-XXXXXX";
+		const int fd = mkstemp(path);
+
+		ASSERT(fd >= 0);
+		ASSERT(write(fd, "{\"a\": [1, \"two\"]}", 17) == 17);
+		close(fd);
+
+		struct josh_file_t file;
+		const char *out = josh_extract_file(&ctx, &file, path, ".a[1]");
+
+		ASSERT(file.len == 17);
+		ASSERT(out == file.data + 10);
+		ASSERT(ctx.len == 5);
+		josh_file_close(&file);
+
+		struct josh_node_t *root = josh_parse_file(&ctx, &file, path);
+
+		ASSERT(root);
+		ASSERT(josh_object_size(root) == 1);
+		josh_file_close(&file);
+
+		unlink(path);
+
+		ASSERT(!josh_extract_file(&ctx, &file, path, ".a"));
+		ASSERT(ctx.error_id == JOSH_ERROR_FILE_NOT_READABLE);
+		josh_file_close(&file);
+	}
+
+	TEST("extract keys from every NDJSON record") {
+		const char *ndjson = "{\"a\": 1, \"b\": \"x\"}\n\n{\"b\": [2]}\r\n{\"a\": tru}\n{\"a\": 4}";
+		struct josh_path_t paths[2];
+
+		ASSERT(josh_compile_key(&ctx, &paths[0], ".a"));
+		ASSERT(josh_compile_key(&ctx, &paths[1], ".b"));
+
+		struct josh_ndjson_t out;
+
+		ASSERT(josh_ndjson_extract(&out, ndjson, strlen(ndjson), paths, 2, 1, false));
+		ASSERT(out.record_count == 4);
+		ASSERT(out.record_offsets[1] == 20);
+		ASSERT(out.record_lens[1] == 11);
+
+		ASSERT(!out.error_ids[0]);
+		ASSERT(out.offsets[0] == 6);
+		ASSERT(out.lens[0] == 1);
+		ASSERT(out.error_ids[1] == JOSH_ERROR_OBJECT_KEY_NOT_FOUND);
+		ASSERT(out.error_ids[2] == JOSH_ERROR_EXPECTED_TRUE);
+		ASSERT(out.offsets[2] == 38);
+		ASSERT(out.offsets[3] == 49);
+
+		ASSERT(out.offsets[4] == 14);
+		ASSERT(out.lens[4] == 3);
+		ASSERT(out.offsets[5] == 26);
+		ASSERT(out.lens[5] == 3);
+		ASSERT(out.error_ids[7] == JOSH_ERROR_OBJECT_KEY_NOT_FOUND);
+
+		josh_ndjson_free(&out);
+	}
+
+	TEST("NDJSON lines with only whitespace are skipped") {
+		const char *ndjson = "{\"a\": 1}\r\n\r\n  \t\r\n{\"a\": 2}\r\n\r\n";
+		struct josh_path_t path;
+
+		ASSERT(josh_compile_key(&ctx, &path, ".a"));
+
+		struct josh_ndjson_t out;
+
+		ASSERT(josh_ndjson_extract(&out, ndjson, strlen(ndjson), &path, 1, 1, false));
+		ASSERT(out.record_count == 2);
+		ASSERT(!out.error_ids[0] && !out.error_ids[1]);
+		ASSERT(out.offsets[1] == 23);
+
+		josh_ndjson_free(&out);
+	}
+
+	TEST("NDJSON records are spread across threads") {
+		const unsigned count = JOSH_CONFIG_NDJSON_BATCH_SIZE * 5 + 3;
+		char *ndjson = malloc(count * 16);
+		size_t len = 0;
+
+		ASSERT(ndjson);
+
+		for (unsigned i = 0; i < count; i++) {
+			len += (size_t)sprintf(ndjson + len, "{\"n\": %u}\n", i);
+		}
+
+		struct josh_path_t path;
+		struct josh_ndjson_t out;
+
+		ASSERT(josh_compile_key(&ctx, &path, ".n"));
+		ASSERT(josh_ndjson_extract(&out, ndjson, len, &path, 1, 4, false));
+		ASSERT(out.record_count == count);
+
+		for (unsigned i = 0; i < count; i++) {
+			ASSERT(!out.error_ids[i]);
+			ASSERT(strtoul(ndjson + out.offsets[i], NULL, 10) == i);
+		}
+
+		josh_ndjson_free(&out);
+		free(ndjson);
+	}
+
+	TEST("predict where keys are from the last document") {
+		const char *docs[] = {
+			"{\"id\": 1, \"name\": \"a\", \"tags\": {\"x\": 1, \"y\": 2}}",
+			"{\"id\": 2, \"name\": \"bb\", \"tags\": {\"x\": 3, \"y\": 4}}",
+			"{\"name\": \"c\", \"id\": 3, \"tags\": {\"y\": 5}}",
+			"{\"id\": 4, \"tags\": {\"y\": 6}}",
+			"{\"id\": 5, \"tags\": {\"y\": 7}}",
+		};
+		const char *names[] = { "\"a\"", "\"bb\"", "\"c\"", NULL, NULL };
+		const char *ys[] = { "2", "4", "5", "6", "7" };
+		const size_t hits[] = { 0, 1, 1, 1, 2 };
+		const size_t misses[] = { 0, 0, 1, 2, 2 };
+
+		struct josh_path_t paths[2];
+		struct josh_result_t results[2];
+		struct josh_shape_t shape = { 0 };
+
+		ASSERT(josh_compile_key(&ctx, &paths[0], ".name"));
+		ASSERT(josh_compile_key(&ctx, &paths[1], ".tags.y"));
+
+		ctx.shape = &shape;
+
+		for (unsigned i = 0; i < 5; i++) {
+			josh_reset(&ctx);
+
+			ASSERT(josh_extract_many_compiled(&ctx, docs[i], paths, results, 2) == (names[i] != NULL));
+
+			if (names[i]) {
+				ASSERT(results[0].len == strlen(names[i]));
+				ASSERT(!strncmp(results[0].ptr, names[i], results[0].len));
+			}
+			else {
+				ASSERT(results[0].error_id == JOSH_ERROR_OBJECT_KEY_NOT_FOUND);
+			}
+
+			ASSERT(results[1].len == 1);
+			ASSERT(results[1].ptr[0] == ys[i][0]);
+			ASSERT(shape.hits == hits[i]);
+			ASSERT(shape.misses == misses[i]);
+		}
+
+		ctx.shape = NULL;
+	}
+
+	TEST("predict where keys are in NDJSON records") {
+		const char *ndjson =
+			"{\"a\": 1, \"b\": 2}\n"
+			"{\"a\": 3, \"b\": 4}\n"
+			"{\"b\": 5, \"a\": 6}\n"
+			"{\"b\": 7, \"a\": 8}\n";
+		struct josh_path_t path;
+		struct josh_ndjson_t out;
+
+		ASSERT(josh_compile_key(&ctx, &path, ".a"));
+		ASSERT(josh_ndjson_extract(&out, ndjson, strlen(ndjson), &path, 1, 1, true));
+		ASSERT(out.record_count == 4);
+		ASSERT(out.shape_hits == 2);
+		ASSERT(out.shape_misses == 1);
+
+		for (unsigned i = 0; i < 4; i++) {
+			ASSERT(!out.error_ids[i]);
+			ASSERT(ndjson[out.offsets[i]] == "1368"[i]);
+		}
+
+		josh_ndjson_free(&out);
+	}
+
+	TEST("parse rejects documents too big for string offsets") {
+		if ((size_t)UINT32_MAX < SIZE_MAX) {
+			struct josh_arena_t tape_arena;
+			josh_arena_init(&tape_arena, NULL, 0);
+
+			struct josh_ctx_t parse_ctx = { .arena = &tape_arena };
+
+			// The length is checked before anything is read.
+			ASSERT(!josh_parse_n(&parse_ctx, "[]", (size_t)UINT32_MAX + 1));
+			ASSERT(parse_ctx.error_id == JOSH_ERROR_DOCUMENT_TOO_LARGE);
+			ASSERT(josh_parse_n(&parse_ctx, "[]", 2));
+
+			josh_arena_free(&tape_arena);
+		}
+	}
+
+	TEST("parse length-bounded input") {
+		const char *json = "[1, 2.5, \"z\"] [";
+
+		struct josh_node_t *root = josh_parse_n(&ctx, json, 13);
+
+		ASSERT(root);
+		ASSERT(josh_array_size(root) == 3);
+		ASSERT(josh_float_value(josh_array_get(root, 1)) > 2.49);
+		ASSERT(josh_float_value(josh_array_get(root, 1)) < 2.51);
+
+		root = josh_parse_n(&ctx, "0.25]", 4);
+
+		ASSERT(root);
+		ASSERT(josh_float_value(root) > 0.24);
+		ASSERT(josh_float_value(root) < 0.26);
+
+		ASSERT(!josh_parse_n(&ctx, json, 15));
+		ASSERT(!josh_parse_n(&ctx, json, 0));
+		ASSERT(ctx.error_id == JOSH_ERROR_EMPTY_VALUE);
 	}
 }